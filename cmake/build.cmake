@@ -23,6 +23,7 @@ function(tp_parse_submodules directory)
         string(STRIP "${TP_SUBDIRS_TMP}" TP_SUBDIRS_TMP)
 
         foreach(subdir ${TP_SUBDIRS_TMP})
+          string(REGEX REPLACE "/+$" "" subdir "${subdir}")
           list(APPEND TP_SUBDIRS ${subdir})
         endforeach()
       endif()
@@ -41,18 +42,48 @@ function(tp_parse_submodules directory)
     string(STRIP "${TP_SUBDIRS_TMP}" TP_SUBDIRS_TMP)
 
     foreach(subdir ${TP_SUBDIRS_TMP})
+      string(REGEX REPLACE "/+$" "" subdir "${subdir}")
       list(APPEND TP_SUBDIRS ${subdir})
     endforeach()
   endif()
 
+  # Modules shared by several SUBPROJECTS are added once so they are only built once.
   list(REMOVE_DUPLICATES TP_SUBDIRS)
 
+  #== Telemetry ====================================================================================
+  # Built here because the modules run all of their commands through it, see build_a.cmake.
+  option(TP_TELEMETRY "Record the time, CPU and memory of each compile, link and tool in telemetry.log." OFF)
+  set(TP_TELEMETRY_TOP "10" CACHE STRING "Number of the largest commands listed by telemetry_report.")
+
+  if(TP_TELEMETRY AND NOT WIN32)
+    if(APPLE)
+      SET(HOST_CXX env -i clang++)
+    else()
+      SET(HOST_CXX g++)
+    endif()
+
+    set(TP_TELEMETRY_CMD "${CMAKE_BINARY_DIR}/tpTelemetry")
+    add_custom_command(
+      OUTPUT  "${TP_TELEMETRY_CMD}"
+      COMMAND ${HOST_CXX} -std=gnu++1z -O2 "${CMAKE_CURRENT_LIST_DIR}/tp_build/tp_telemetry/tp_telemetry.cpp" -o "${TP_TELEMETRY_CMD}"
+      DEPENDS "${CMAKE_CURRENT_LIST_DIR}/tp_build/tp_telemetry/tp_telemetry.cpp"
+    )
+    add_custom_target(tp_telemetry_tool DEPENDS "${TP_TELEMETRY_CMD}")
+
+    add_custom_target(telemetry_report
+                      COMMAND "${TP_TELEMETRY_CMD}" report --top=${TP_TELEMETRY_TOP} --trace=telemetry.json telemetry.log
+                      DEPENDS tp_telemetry_tool
+                      WORKING_DIRECTORY "${CMAKE_BINARY_DIR}")
+  endif()
+
   foreach(subdir ${TP_SUBDIRS})
     add_subdirectory(${subdir})
   endforeach()
 
   set(TP_TEST_TARGETS "")
   set(TP_TESTS "")
+  set(TP_BENCH_TARGETS "")
+  set(TP_BENCHMARKS "")
   foreach(subdir ${TP_SUBDIRS})
     set(TP_TEMPLATE "")
     execute_process(COMMAND bash "${CMAKE_CURRENT_LIST_DIR}/tp_build/cmake/extract_vars.sh" TEMPLATE
@@ -63,6 +94,9 @@ function(tp_parse_submodules directory)
     if(TP_TEMPLATE STREQUAL "test")
       set(TP_TESTS "${TP_TESTS}./${subdir}/${subdir}\n")
       list(APPEND TP_TEST_TARGETS "${subdir}")
+    elseif(TP_TEMPLATE STREQUAL "bench")
+      set(TP_BENCHMARKS "${TP_BENCHMARKS}./${subdir}/${subdir}\n")
+      list(APPEND TP_BENCH_TARGETS "${subdir}")
     endif()
   endforeach()
 
@@ -72,9 +106,104 @@ function(tp_parse_submodules directory)
                  "${CMAKE_CURRENT_BINARY_DIR}/run_tests.sh" 
                  COPYONLY)
 
+  #== tpTest =======================================================================================
+  set(TP_TEST_JOBS "0" CACHE STRING "Number of tests to run in parallel, 0 uses all cores.")
+  set(TP_TEST_TIMEOUT "0" CACHE STRING "Per test timeout in seconds, 0 disables the timeout.")
+  set(TP_TEST_SHARD "" CACHE STRING "Only run one shard of the tests, I/N where 1 <= I <= N.")
+  set(TP_TEST_HISTORY "" CACHE STRING "Test reports from previous runs used to order and shard tests.")
+
+  option(TP_PERF_COUNTERS "Record hardware performance counters in tests and benchmarks." OFF)
+  set(TP_BENCH_PIN_CPU "" CACHE STRING "Run the benchmarks pinned to this CPU.")
+
+  set(TP_TEST_ARGS -j${TP_TEST_JOBS} --timeout=${TP_TEST_TIMEOUT})
+  set(TP_BENCH_ARGS "")
+  if(TP_PERF_COUNTERS)
+    list(APPEND TP_TEST_ARGS --perf-counters)
+    list(APPEND TP_BENCH_ARGS --perf-counters)
+  endif()
+  if(NOT "${TP_BENCH_PIN_CPU}" STREQUAL "")
+    list(APPEND TP_BENCH_ARGS --pin-cpu=${TP_BENCH_PIN_CPU})
+  endif()
+  if(NOT "${TP_TEST_SHARD}" STREQUAL "")
+    list(APPEND TP_TEST_ARGS --shard=${TP_TEST_SHARD})
+  endif()
+  foreach(f ${TP_TEST_HISTORY})
+    list(APPEND TP_TEST_ARGS --history=${f})
+  endforeach()
+
+  if(APPLE)
+    SET(HOST_CXX env -i clang++)
+  else()
+    SET(HOST_CXX g++)
+  endif()
+
+  set(TP_TEST_CMD "${CMAKE_CURRENT_BINARY_DIR}/tpTest")
+  add_custom_command(
+    OUTPUT  "${TP_TEST_CMD}"
+    COMMAND ${HOST_CXX} -std=gnu++1z -O2 "${CMAKE_CURRENT_LIST_DIR}/tp_build/tp_test/tp_test.cpp" -o "${TP_TEST_CMD}"
+    DEPENDS "${CMAKE_CURRENT_LIST_DIR}/tp_build/tp_test/tp_test.cpp"
+  )
+
   add_custom_target(tests
-                    COMMAND "${CMAKE_CURRENT_BINARY_DIR}/run_tests.sh"
-                    DEPENDS "${TP_TEST_TARGETS}"
+                    COMMAND "${CMAKE_CURRENT_BINARY_DIR}/run_tests.sh" ${TP_TEST_ARGS}
+                    DEPENDS "${TP_TEST_TARGETS}" "${TP_TEST_CMD}"
                     WORKING_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}")
-endfunction()
 
+  #== Benchmarks ===================================================================================
+  file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/benchmarks.txt" "${TP_BENCHMARKS}")
+
+  configure_file("${CMAKE_CURRENT_LIST_DIR}/tp_build/tp_bench/run_benchmarks.sh"
+                 "${CMAKE_CURRENT_BINARY_DIR}/run_benchmarks.sh"
+                 COPYONLY)
+
+  add_custom_target(benchmarks
+                    COMMAND "${CMAKE_CURRENT_BINARY_DIR}/run_benchmarks.sh" ${TP_BENCH_ARGS}
+                    DEPENDS "${TP_BENCH_TARGETS}"
+                    WORKING_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}")
+
+  #== Benchmark regression check ===================================================================
+  cmake_host_system_information(RESULT TP_HOST_NAME QUERY HOSTNAME)
+  set(TP_BENCH_MACHINE "${TP_HOST_NAME}" CACHE STRING "Name used to select the benchmark baseline.")
+  set(TP_BENCH_BASELINE_DIR "${CMAKE_CURRENT_LIST_DIR}/${directory}/bench_baselines" CACHE PATH "Directory containing a benchmark baseline for each machine.")
+  set(TP_BENCH_THRESHOLD "5" CACHE STRING "Percent slow down of a benchmark median that fails bench-check.")
+  set(TP_BENCH_ALPHA "0.01" CACHE STRING "Significance level used by bench-check.")
+
+  set(TP_BENCH_CHECK_CMD "${CMAKE_CURRENT_BINARY_DIR}/tpBenchCheck")
+  add_custom_command(
+    OUTPUT  "${TP_BENCH_CHECK_CMD}"
+    COMMAND ${HOST_CXX} -std=gnu++1z -O2 "${CMAKE_CURRENT_LIST_DIR}/tp_build/tp_bench/tp_bench_check.cpp" -o "${TP_BENCH_CHECK_CMD}"
+    DEPENDS "${CMAKE_CURRENT_LIST_DIR}/tp_build/tp_bench/tp_bench_check.cpp"
+  )
+
+  add_custom_target(bench-check
+                    COMMAND "${TP_BENCH_CHECK_CMD}" --threshold=${TP_BENCH_THRESHOLD} --alpha=${TP_BENCH_ALPHA} "${TP_BENCH_BASELINE_DIR}/${TP_BENCH_MACHINE}" bench_results
+                    DEPENDS "${TP_BENCH_CHECK_CMD}"
+                    WORKING_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}")
+  add_dependencies(bench-check benchmarks)
+
+  add_custom_target(bench-baseline
+                    COMMAND "${TP_BENCH_CHECK_CMD}" --update "${TP_BENCH_BASELINE_DIR}/${TP_BENCH_MACHINE}" bench_results
+                    DEPENDS "${TP_BENCH_CHECK_CMD}"
+                    WORKING_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}")
+  add_dependencies(bench-baseline benchmarks)
+
+  #== Profile ======================================================================================
+  # Build with -DTP_PROF=ON then: cmake --build . --target profile
+  set(TP_PROFILE_TARGET "" CACHE STRING "App or bench module to run under perf by the profile target.")
+  set(TP_PROFILE_ARGS "" CACHE STRING "Arguments passed to the profiled program.")
+
+  if(NOT "${TP_PROFILE_TARGET}" STREQUAL "")
+    set(TP_FLAMEGRAPH_CMD "${CMAKE_CURRENT_BINARY_DIR}/tpFlameGraph")
+    add_custom_command(
+      OUTPUT  "${TP_FLAMEGRAPH_CMD}"
+      COMMAND ${HOST_CXX} -std=gnu++1z -O2 "${CMAKE_CURRENT_LIST_DIR}/tp_build/tp_prof/tp_flamegraph.cpp" -o "${TP_FLAMEGRAPH_CMD}"
+      DEPENDS "${CMAKE_CURRENT_LIST_DIR}/tp_build/tp_prof/tp_flamegraph.cpp"
+    )
+
+    add_custom_target(profile
+                      COMMAND bash "${CMAKE_CURRENT_LIST_DIR}/tp_build/tp_prof/profile.sh" "${TP_FLAMEGRAPH_CMD}" "${CMAKE_CURRENT_BINARY_DIR}/profile" "$<TARGET_FILE:${TP_PROFILE_TARGET}>" ${TP_PROFILE_ARGS}
+                      DEPENDS "${TP_FLAMEGRAPH_CMD}" "${TP_PROFILE_TARGET}"
+                      WORKING_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}"
+                      USES_TERMINAL)
+  endif()
+endfunction()
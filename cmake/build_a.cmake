@@ -2,6 +2,13 @@ set(CMAKE_CXX_STANDARD 17)
 set(CMAKE_CXX_STANDARD_REQUIRED ON)
 set(CMAKE_CXX_EXTENSIONS OFF)
 
+option(TP_SANITIZE "Build with the address and undefined behaviour sanitizers." OFF)
+option(TP_SANITIZE_THREAD "Build with the thread sanitizer." OFF)
+option(TP_PROF "Build optimized with frame pointers and debug info for profiling with perf." OFF)
+option(TP_RELEASE_INSTALL "Install stripped apps with their debug info in separate compressed files." OFF)
+set(TP_CACHE_DIR "" CACHE PATH "Cache the objects of each module in this directory, see tp_build/tp_cache.")
+set(TP_CACHE_SHARED_DIR "" CACHE PATH "A second object cache shared with other checkouts or machines.")
+
 # For documentation of the supported variabls see:
 # https://github.com/tdp-libs/tp_build/blob/master/documentation/variables.md
 function(tp_parse_vars)  
@@ -218,6 +225,31 @@ function(tp_parse_vars)
     list(APPEND TP_DEFINES -DTP_LINUX)
     set(CMAKE_CXX_FLAGS ${CMAKE_CXX_FLAGS} "-pthread")
       list(APPEND TP_LIBRARIES "pthread")
+
+    if(TP_SANITIZE)
+      #dnf install libasan libubsan
+      list(APPEND TP_BUILD_FLAGS -fsanitize=address -fsanitize=undefined -fsanitize-address-use-after-scope -fstack-protector-all)
+      list(APPEND TP_LINK_FLAGS  -fsanitize=address -fsanitize=undefined -fsanitize-address-use-after-scope -fstack-protector-all)
+    endif()
+
+    if(TP_SANITIZE_THREAD)
+      #dnf install libtsan
+      list(APPEND TP_BUILD_FLAGS -fsanitize=thread)
+      list(APPEND TP_LINK_FLAGS  -fsanitize=thread)
+    endif()
+
+    if(TP_PROF)
+      #Optimized code with frame pointers and debug info so that perf can walk the call stacks.
+      list(APPEND TP_BUILD_FLAGS -O2 -g -fno-omit-frame-pointer)
+      list(APPEND TP_LINK_FLAGS  -g)
+    endif()
+
+    if(TP_RELEASE_INSTALL)
+      #Keep the debug info and add a build ID, the installed app is split by tp_install/split_debug.sh.
+      #-O1 and the GNU hash style make the dynamic symbol tables faster to look up at load time.
+      list(APPEND TP_BUILD_FLAGS -g)
+      list(APPEND TP_LINK_FLAGS  -Wl,--build-id -Wl,-O1 -Wl,--hash-style=gnu)
+    endif()
   elseif(WIN32)
     list(APPEND TP_DEFINES -DTP_WIN32)
   endif()
@@ -284,7 +316,7 @@ function(tp_parse_vars)
   endif()
 
   #== STATIC_INIT ==================================================================================
-  if(TP_TEMPLATE STREQUAL "app" OR TP_TEMPLATE STREQUAL "test")
+  if(TP_TEMPLATE STREQUAL "app" OR TP_TEMPLATE STREQUAL "test" OR TP_TEMPLATE STREQUAL "bench")
     if(NOT "${TP_STATIC_INIT}" STREQUAL "")
       string(REPLACE " " ";" TP_STATIC_INIT ${TP_STATIC_INIT})
       string(STRIP "${TP_STATIC_INIT}" TP_STATIC_INIT)
@@ -396,23 +428,49 @@ function(tp_parse_vars)
     endif()
   endif()
 
+  #== Release install ==============================================================================
+  # Strips an installed binary and moves its debug info into lib/debug using split_debug.sh.
+  macro(tp_install_split_debug file)
+    install(CODE "execute_process(COMMAND bash \"${CMAKE_CURRENT_LIST_DIR}/../tp_build/tp_install/split_debug.sh\"
+                                          \"\$ENV{DESTDIR}${CMAKE_INSTALL_PREFIX}/lib/debug\"
+                                          \"\$ENV{DESTDIR}${CMAKE_INSTALL_PREFIX}/${file}\"
+                                  RESULT_VARIABLE TP_SPLIT_DEBUG_RESULT)
+                  if(NOT TP_SPLIT_DEBUG_RESULT EQUAL 0)
+                    message(FATAL_ERROR \"Failed to split the debug info of ${file}\")
+                  endif()")
+  endmacro()
+
   #== Build Lib ====================================================================================
   if(TP_TEMPLATE STREQUAL "lib")
     include_directories(${TP_INCLUDEPATHS})
     link_directories(${TP_LIBRARYPATHS})
     add_definitions(${TP_DEFINES})
+    add_compile_options(${TP_BUILD_FLAGS})
     if(WIN32)
       add_library("${TP_TARGET}" STATIC ${TP_SOURCES} ${TP_HEADERS} ${TP_RESOURCES})
     else()
       add_library("${TP_TARGET}" ${TP_SOURCES} ${TP_HEADERS} ${TP_RESOURCES})
     endif()
+
+    # Shared libraries are installed with the apps that load them and are split the same way.
+    get_target_property(TP_LIBRARY_TYPE "${TP_TARGET}" TYPE)
+    if(TP_RELEASE_INSTALL AND UNIX AND NOT APPLE AND TP_LIBRARY_TYPE STREQUAL "SHARED_LIBRARY")
+      set_property(TARGET "${TP_TARGET}" APPEND_STRING PROPERTY LINK_FLAGS " -Wl,--build-id -Wl,-O1 -Wl,--hash-style=gnu")
+      install(TARGETS "${TP_TARGET}" LIBRARY DESTINATION ${CMAKE_INSTALL_PREFIX}/lib)
+      tp_install_split_debug("lib/${CMAKE_SHARED_LIBRARY_PREFIX}${TP_TARGET}${CMAKE_SHARED_LIBRARY_SUFFIX}")
+    endif()
   endif()
 
   #== Build App ====================================================================================
-  if(TP_TEMPLATE STREQUAL "app" OR TP_TEMPLATE STREQUAL "test")
+  if(TP_TEMPLATE STREQUAL "bench")
+    list(APPEND TP_INCLUDEPATHS "${CMAKE_CURRENT_LIST_DIR}/../tp_build/tp_bench/inc")
+  endif()
+
+  if(TP_TEMPLATE STREQUAL "app" OR TP_TEMPLATE STREQUAL "test" OR TP_TEMPLATE STREQUAL "bench")
     include_directories(${TP_INCLUDEPATHS})
     link_directories(${TP_LIBRARYPATHS})
     add_definitions(${TP_DEFINES})
+    add_compile_options(${TP_BUILD_FLAGS})
     
     if(ANDROID)
       # For Android we build a shared library then call it from Java.
@@ -421,7 +479,7 @@ function(tp_parse_vars)
       add_executable("${TP_TARGET}" ${TP_SOURCES} ${TP_HEADERS} ${TP_RESOURCES})
     endif()
 
-    target_link_libraries("${TP_TARGET}" ${TP_LIBRARIES})
+    target_link_libraries("${TP_TARGET}" ${TP_LIBRARIES} ${TP_LINK_FLAGS})
     if(TP_TEMPLATE STREQUAL "app")
       if(APPLE)
         install(TARGETS "${TP_TARGET}" 
@@ -447,10 +505,53 @@ function(tp_parse_vars)
         install(TARGETS "${TP_TARGET}" 
                 RUNTIME DESTINATION ${CMAKE_INSTALL_PREFIX}/bin
                 LIBRARY DESTINATION ${CMAKE_INSTALL_PREFIX}/lib)
+
+        if(TP_RELEASE_INSTALL AND UNIX)
+          tp_install_split_debug("bin/${TP_TARGET}")
+        endif()
       endif()
     endif()
   endif()
 
+  #== Build cache ==================================================================================
+  # Compiles go through tpCache which looks them up by the command line and the source, then checks
+  # the headers listed in the depfile of the cached result.
+  if(NOT "${TP_CACHE_DIR}" STREQUAL "" AND NOT WIN32 AND TARGET "${TP_TARGET}")
+    set(TP_CACHE_CMD "${CMAKE_BINARY_DIR}/tpCache")
+    if(NOT TARGET tp_cache_tool)
+      add_custom_command(
+        OUTPUT  "${TP_CACHE_CMD}"
+        COMMAND ${HOST_CXX} -std=gnu++1z -O2 "${CMAKE_CURRENT_LIST_DIR}/../tp_build/tp_cache/tp_cache.cpp" -o "${TP_CACHE_CMD}"
+        DEPENDS "${CMAKE_CURRENT_LIST_DIR}/../tp_build/tp_cache/tp_cache.cpp"
+      )
+      add_custom_target(tp_cache_tool DEPENDS "${TP_CACHE_CMD}")
+    endif()
+
+    add_dependencies("${TP_TARGET}" tp_cache_tool)
+
+    set(TP_CACHE_LAUNCHER "${TP_CACHE_CMD}" run "--cache-dir=${TP_CACHE_DIR}" "--root=${CMAKE_SOURCE_DIR}" "--build-root=${CMAKE_BINARY_DIR}")
+    if(NOT "${TP_CACHE_SHARED_DIR}" STREQUAL "")
+      list(APPEND TP_CACHE_LAUNCHER "--shared-dir=${TP_CACHE_SHARED_DIR}")
+    endif()
+    list(APPEND TP_CACHE_LAUNCHER "--")
+    set_target_properties("${TP_TARGET}" PROPERTIES C_COMPILER_LAUNCHER "${TP_CACHE_LAUNCHER}" CXX_COMPILER_LAUNCHER "${TP_CACHE_LAUNCHER}")
+  endif()
+
+  #== Telemetry ====================================================================================
+  # Every compile, link and custom command of the module runs through tpTelemetry which records its
+  # time and memory in telemetry.log, tpTelemetry is built by tp_parse_submodules.
+  if(TP_TELEMETRY AND NOT WIN32 AND TARGET "${TP_TARGET}")
+    set(TP_TELEMETRY_RUN "${CMAKE_BINARY_DIR}/tpTelemetry run --log=${CMAKE_BINARY_DIR}/telemetry.log --")
+    set_property(DIRECTORY PROPERTY RULE_LAUNCH_COMPILE "${TP_TELEMETRY_RUN}")
+    set_property(DIRECTORY PROPERTY RULE_LAUNCH_LINK "${TP_TELEMETRY_RUN}")
+    set_property(DIRECTORY PROPERTY RULE_LAUNCH_CUSTOM "${TP_TELEMETRY_RUN}")
+    foreach(t "${TP_TARGET}" tp_cache_tool)
+      if(TARGET "${t}")
+        add_dependencies("${t}" tp_telemetry_tool)
+      endif()
+    endforeach()
+  endif()
+
   #== Build Subdirs ================================================================================
   if(NOT TP_TEMPLATE STREQUAL "subdirs")
     if(TP_QT_MODULES)
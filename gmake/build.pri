@@ -12,5 +12,11 @@ include $(ROOT)$(PROJECT_DIR)/project.conf
 export PROJECT_DIR
 
 include $(ROOT)$(PROJECT_DIR)/submodules.pri
+$(foreach p,$(SUBPROJECTS),$(eval include $(ROOT)$(p)/submodules.pri))
+
+# Modules shared by several SUBPROJECTS are built once, keeping the order of their first use.
+tp_unique = $(if $(1),$(firstword $(1)) $(call tp_unique,$(filter-out $(firstword $(1)),$(1))))
+SUBDIRS := $(call tp_unique,$(patsubst %/,%,$(SUBDIRS)))
+
 include $(ROOT)tp_build/gmake/$(TP_BUILD_TYPE)/common.pri
 include $(ROOT)tp_build/gmake/$(TP_BUILD_TYPE)/build.pri
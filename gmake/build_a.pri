@@ -16,6 +16,11 @@ include $(ROOT)tp_build/gmake/parse_dependencies.pri
 # Bring in the source files for this module
 include vars.pri
 
+# Benchmarks get the tp_bench harness
+ifeq ($(TEMPLATE), bench)
+INCLUDEPATHS += tp_build/tp_bench/inc/
+endif
+
 #All must be the first target in the makefile
 .PHONY: all
 all: pages tp_copy all_a
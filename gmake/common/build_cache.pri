@@ -0,0 +1,20 @@
+# Content addressed cache of the objects and archives of each module, set these in project.inc or on
+# the command line.
+#   make TP_CACHE_DIR=~/.cache/tp_build
+#
+# TP_CACHE_DIR        - Local cache directory, the cache is only used when this is set.
+# TP_CACHE_SHARED_DIR - Optional second cache shared with other checkouts or machines, for example on
+#                       a network drive. Hits are copied to the local cache.
+# TP_CACHE_VERBOSE    - Print each hit and miss.
+#
+# Each compile and archive is looked up by its command line and the contents of its sources or
+# objects, compiles are then checked against the contents of every header listed in the depfile they
+# wrote last time. See tp_build/tp_cache/tp_cache.cpp.
+
+TP_CACHE_CMD = $(ROOT)$(BUILD_DIR)tpCache
+TP_CACHE_SRC = $(ROOT)tp_build/tp_cache/tp_cache.cpp
+
+ifdef TP_CACHE_DIR
+TP_CACHE_ARGS = --cache-dir=$(TP_CACHE_DIR) --root=$(ROOT) $(if $(TP_CACHE_SHARED_DIR),--shared-dir=$(TP_CACHE_SHARED_DIR)) $(if $(TP_CACHE_VERBOSE),--verbose)
+tp_cache = $(TP_CACHE_CMD) run $(TP_CACHE_ARGS) --output=$@ --
+endif
@@ -0,0 +1,16 @@
+# Critical path analysis of the build, set these in project.inc or on the command line.
+#   make TP_BUILD_TIMES=1 && make critical-path
+#
+# TP_BUILD_TIMES - Each compile, archive and link appends its start and end time to build_times.log
+#                  in the build directory, in the same format as the .ninja_log of ninja builds.
+#
+# critical-path prints the critical path of a full build, the speedup that more cores can give and
+# the modules that serialize the build, and writes critical_path.json, a Chrome trace of the build.
+
+ifdef TP_BUILD_TIMES
+TP_TIME = $(ROOT)tp_build/tp_critical_path/time_command.sh $(ROOT)$(BUILD_DIR)build_times.log $@
+endif
+
+TP_CRITICAL_PATH_CMD = $(ROOT)$(BUILD_DIR)tpCriticalPath
+TP_CRITICAL_PATH_SRC = $(ROOT)tp_build/tp_critical_path/tp_critical_path.cpp
+TP_CRITICAL_PATH_MODULES = $(foreach m,$(SUBDIRS),"--module=$(m):$($(m)_TARGET):$(strip $($(m)_DEPENDENCIES))")
@@ -0,0 +1,79 @@
+# Loads every module in SUBDIRS into variables prefixed with the module name, for example
+# libA_SOURCES, so that the top level makefile can describe the whole tree as one build graph instead
+# of calling make in each module directory. Each module sees the same project wide values that the
+# per module build_a.pri would give it.
+
+TP_MODULE_VARS = TARGET TEMPLATE SOURCES HEADERS TP_RC TP_STATIC_INIT PAGES TP_COPY INCLUDEPATHS LIBRARIES LIBS LIBRARYPATHS DEFINES CFLAGS CCFLAGS CXXFLAGS LFLAGS
+
+$(foreach v,$(TP_MODULE_VARS),$(eval TP_GLOBAL_$(v) := $$($(v))))
+
+tp_reset_vars = $(foreach v,$(TP_MODULE_VARS),$(eval $(v) := $$(TP_GLOBAL_$(v))))
+tp_store_vars = $(foreach v,$(TP_MODULE_VARS),$(eval $(1)_$(v) := $$($(v))))
+
+define TP_LOAD_MODULE
+$$(call tp_reset_vars)
+DEPENDENCIES :=
+include $(ROOT)$(1)/dependencies.pri
+$(1)_DEPENDENCIES := $$(DEPENDENCIES)
+include $(ROOT)tp_build/gmake/parse_dependencies.pri
+include $(ROOT)$(1)/vars.pri
+ifeq ($$(TEMPLATE), bench)
+INCLUDEPATHS += tp_build/tp_bench/inc/
+endif
+$$(call tp_store_vars,$(1))
+endef
+
+$(foreach m,$(SUBDIRS),$(eval $(call TP_LOAD_MODULE,$(m))))
+$(call tp_reset_vars)
+DEPENDENCIES :=
+
+# Paths of a module relative to the top level directory.
+tp_module_dir = $(ROOT)$(1)/
+tp_module_obj_dir = $(ROOT)$(BUILD_DIR)$($(1)_TARGET)/
+tp_module_includes = $(patsubst -I$(ROOT)/%,-I/%,$(addprefix -I$(ROOT),$($(1)_INCLUDEPATHS)))
+tp_module_defines = $(addprefix -D,$($(1)_DEFINES))
+
+# Libraries that are built by this tree, anything else in LIBRARIES is expected to exist already.
+TP_LIB_TARGETS = $(foreach m,$(SUBDIRS),$(if $(filter lib,$($(m)_TEMPLATE)),$($(m)_TARGET)))
+
+ifeq ($(ROOT_URL),)
+ROOT_URL = $(CURDIR)/$(BUILD_DIR)pages/
+endif
+export ROOT_URL
+
+# Pages and TP_COPY files, the same as common/pages.pri and common/tp_copy.pri do for a single
+# module. Call TP_MODULE_EXTRAS after the "all" target and add $(m)_EXTRAS to the module target.
+define TP_MODULE_PAGE
+$(call tp_module_obj_dir,$(1))$(2)/Makefile: $(call tp_module_dir,$(1))$(2) $(ROOT)tp_build/gmake/common/template_page_Makefile
+	$(MKDIR) $$(@D)
+	echo "SOURCE_DIR=`realpath $$<`/" > $$@
+	echo "ROOT_DIR=`realpath $(ROOT)`/" >> $$@
+	echo "BUILD_DIR=`realpath $(ROOT)$(BUILD_DIR)`/" >> $$@
+	echo "PAGE_NAME=$(2)" >> $$@
+	cat $(ROOT)tp_build/gmake/common/template_page_Makefile >> $$@
+
+.PHONY: $(call tp_module_obj_dir,$(1))$(2)/make
+$(call tp_module_obj_dir,$(1))$(2)/make: $(call tp_module_obj_dir,$(1))$(2)/Makefile $$(TP_PAGE_TOOLS)
+	cd $$(@D) && $$(MAKE)
+endef
+
+define TP_MODULE_COPY
+$(ROOT)$(BUILD_DIR)$(2): $(call tp_module_dir,$(1))$(2) | $$(TP_COPY_CMD)
+	$(MKDIR) $$(@D)
+	$$(TP_COPY_CMD) $$(TP_COPY_ARGS) $$< $$@
+
+# Make can't see changes inside a directory so these always run tpCopy, which only copies the files
+# that changed.
+ifneq ($(wildcard $(call tp_module_dir,$(1))$(2)/.),)
+.PHONY: $(ROOT)$(BUILD_DIR)$(2)
+endif
+endef
+
+define TP_MODULE_EXTRAS
+include $(ROOT)tp_build/gmake/common/page_tools.pri
+include $(ROOT)tp_build/gmake/common/tp_copy_tool.pri
+include $(ROOT)tp_build/gmake/common/telemetry.pri
+$(1)_EXTRAS := $(foreach p,$($(1)_PAGES),$(call tp_module_obj_dir,$(1))$(p)/make) $(addprefix $(ROOT)$(BUILD_DIR),$($(1)_TP_COPY))
+$$(foreach p,$$($(1)_PAGES),$$(eval $$(call TP_MODULE_PAGE,$(1),$$(p))))
+$$(foreach f,$$($(1)_TP_COPY),$$(eval $$(call TP_MODULE_COPY,$(1),$$(f))))
+endef
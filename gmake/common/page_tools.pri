@@ -0,0 +1,22 @@
+# The host tools used by the page Makefiles, they are built once here rather than by each page
+# Makefile so that pages built in parallel don't race to build them.
+ifndef TP_MUSTACHE_CMD
+TP_MUSTACHE_CMD = $(ROOT)$(BUILD_DIR)tpMustache
+TP_MUSTACHE_SRC = $(ROOT)tp_build/pages/tp_mustache.cpp
+
+TP_PAGE_OPTIMIZE_CMD = $(ROOT)$(BUILD_DIR)tpPageOptimize
+TP_PAGE_OPTIMIZE_SRC = $(ROOT)tp_build/pages/tp_page_optimize.cpp
+
+# Only built when pages are optimized, see TP_PAGES_OPTIMIZE in template_page_Makefile.
+TP_PAGE_TOOLS = $(TP_MUSTACHE_CMD) $(if $(TP_PAGES_OPTIMIZE),$(TP_PAGE_OPTIMIZE_CMD))
+
+$(TP_MUSTACHE_CMD): $(TP_MUSTACHE_SRC)
+	$(MKDIR) $(@D)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_MUSTACHE_SRC) -o $(TP_MUSTACHE_CMD)
+
+$(TP_PAGE_OPTIMIZE_CMD): $(TP_PAGE_OPTIMIZE_SRC)
+	$(MKDIR) $(@D)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_PAGE_OPTIMIZE_SRC) -o $(TP_PAGE_OPTIMIZE_CMD)
+
+export TP_PAGES_OPTIMIZE
+endif
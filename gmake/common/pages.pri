@@ -7,11 +7,13 @@ ROOT_URL = $(ROOT)$(BUILD_DIR)pages/
 endif
 export ROOT_URL
 
+include $(ROOT)tp_build/gmake/common/page_tools.pri
+
 pages: $(PAGES_BUILD_DIRS) $(PAGES_MAKEFILES) $(PAGES_MAKETARGETS)
 #	-for d in $(PAGES_MAKEFILES) ; do (cd `dirname $$d`; $(MAKE)); done
 
 .PHONY: $(PAGES_MAKETARGETS)
-$(PAGES_MAKETARGETS):
+$(PAGES_MAKETARGETS): $(TP_PAGE_TOOLS)
 	cd `dirname $@` && $(MAKE)
 
 $(ROOT)$(BUILD_DIR)$(TARGET)/%/Makefile: % $(ROOT)tp_build/gmake/common/template_page_Makefile
@@ -0,0 +1,21 @@
+# Sanitizer and profiling builds, set these in project.inc or on the command line.
+#   make TP_SANITIZE=1
+
+ifdef TP_SANITIZE
+#dnf install libasan libubsan
+CFLAGS += -fsanitize=address -fsanitize=undefined -fsanitize-address-use-after-scope -fstack-protector-all
+LFLAGS += -fsanitize=address -fsanitize=undefined -fsanitize-address-use-after-scope -fstack-protector-all
+endif
+
+ifdef TP_SANITIZE_THREAD
+#dnf install libtsan
+CFLAGS += -fsanitize=thread
+LFLAGS += -fsanitize=thread
+endif
+
+ifdef TP_PROF
+#Optimized code with frame pointers and debug info so that perf can walk the call stacks, see
+#tp_prof/profile.sh.
+CFLAGS += -O2 -g -fno-omit-frame-pointer
+LFLAGS += -g
+endif
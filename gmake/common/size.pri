@@ -0,0 +1,41 @@
+# Size report of the linked output, each platform sets these before including this file.
+#   TP_SIZE_NAME  - Name of the report, used for the baseline file name.
+#   TP_SIZE_MAPS  - Link maps written with -Wl,-Map.
+#   TP_SIZE_FILES - Output files to report the size on disk of, these depend on the link.
+#   TP_SIZE_MEMORY - Report the flash and RAM used by each module.
+#
+# "make size-report" prints the bytes used by each module, section and symbol, the changes since the
+# baseline and fails if a module is over its budget. "make size-baseline" stores a new baseline.
+#   TP_SIZE_BUDGETS = libA:64K app:128K total:1M
+#
+# Microcontroller builds check the flash and RAM budgets after every link, so that an image that no
+# longer fits the device fails the build instead of being found on the hardware.
+#   TP_FLASH_BUDGETS = total:32K libA:8K
+#   TP_RAM_BUDGETS = total:2K
+
+TP_SIZE_BASELINE_DIR ?= $(ROOT)$(PROJECT_DIR)/size_baselines
+TP_SIZE_SYMBOLS ?= 20
+
+TP_SIZE_CMD = $(ROOT)$(BUILD_DIR)tpSize
+TP_SIZE_SRC = $(ROOT)tp_build/tp_size/tp_size.cpp
+TP_SIZE_ARGS = --build-dir=$(ROOT)$(BUILD_DIR) --symbols=$(TP_SIZE_SYMBOLS) $(addprefix --file=,$(TP_SIZE_FILES)) $(if $(TP_SIZE_MEMORY),--memory)
+TP_SIZE_MEMORY_BUDGETS = $(addprefix --flash-budget=,$(TP_FLASH_BUDGETS)) $(addprefix --ram-budget=,$(TP_RAM_BUDGETS))
+TP_SIZE_CHECK = $(if $(strip $(TP_SIZE_MEMORY_BUDGETS)),$(ROOT)$(BUILD_DIR)size/$(TP_SIZE_NAME).check)
+
+size-report: all $(TP_SIZE_CMD)
+	$(TP_SIZE_CMD) $(TP_SIZE_ARGS) $(addprefix --budget=,$(TP_SIZE_BUDGETS)) $(TP_SIZE_MEMORY_BUDGETS) --baseline=$(TP_SIZE_BASELINE_DIR)/$(TP_SIZE_NAME).txt --save=$(ROOT)$(BUILD_DIR)size/$(TP_SIZE_NAME).txt $(TP_SIZE_MAPS)
+
+size-baseline: all $(TP_SIZE_CMD)
+	$(TP_SIZE_CMD) $(TP_SIZE_ARGS) --save=$(TP_SIZE_BASELINE_DIR)/$(TP_SIZE_NAME).txt $(TP_SIZE_MAPS)
+
+# The full report is kept next to the stamp, only the flash and RAM summary is printed.
+$(TP_SIZE_CHECK): $(TP_SIZE_FILES) $(TP_SIZE_CMD) $(ROOT)$(PROJECT_DIR)/project.conf
+	$(MKDIR) $(@D)
+	$(TP_SIZE_CMD) $(TP_SIZE_ARGS) $(TP_SIZE_MEMORY_BUDGETS) $(TP_SIZE_MAPS) > $@.txt
+	tail -n 2 $@.txt
+	touch $@
+
+$(TP_SIZE_CMD): $(TP_SIZE_SRC)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_SIZE_SRC) -o $(TP_SIZE_CMD)
+
+.PHONY: size-report size-baseline
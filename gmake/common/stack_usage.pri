@@ -0,0 +1,22 @@
+# Stack usage analysis, set these in project.inc or on the command line.
+#   make TP_STACK_USAGE=1 stack-report
+#
+# TP_STACK_USAGE   - Compile with -fstack-usage and -fcallgraph-info=su (GCC 10 or later), this writes
+#                    a .su and .ci file next to each object that tpStackUsage combines to find the
+#                    worst case stack depth of each entry point.
+# TP_STACK_WARNING - Warn about any function with a frame larger than this many bytes.
+# TP_STACK_ENTRIES - Entry points to report, for example main, interrupt handlers and thread
+#                    functions. By default every function that is not called by another is reported.
+# TP_STACK_BUDGETS - entry:bytes, stack-report fails if an entry point can use more stack than this or
+#                    its depth can't be bounded because of recursion, alloca or indirect calls.
+
+ifdef TP_STACK_USAGE
+CFLAGS += -fstack-usage -fcallgraph-info=su
+ifdef TP_STACK_WARNING
+CFLAGS += -Wstack-usage=$(TP_STACK_WARNING)
+endif
+endif
+
+TP_STACK_USAGE_CMD = $(ROOT)$(BUILD_DIR)tpStackUsage
+TP_STACK_USAGE_SRC = $(ROOT)tp_build/tp_stack/tp_stack_usage.cpp
+TP_STACK_USAGE_ARGS = $(addprefix --entry=,$(TP_STACK_ENTRIES)) $(addprefix --budget=,$(TP_STACK_BUDGETS))
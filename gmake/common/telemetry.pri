@@ -0,0 +1,29 @@
+# Build telemetry, set these in project.inc or on the command line.
+#   make TP_TELEMETRY=1 && make telemetry-report
+#
+# TP_TELEMETRY     - Each compile, archive, link and tool runs through tpTelemetry, which appends its
+#                    wall time, user and system time, peak memory, inputs and outputs to
+#                    telemetry.log in the build directory.
+# TP_TELEMETRY_TOP - Number of the largest commands that telemetry-report lists, default: 10
+#
+# telemetry-report prints the time and memory used by each tool and the largest commands and writes
+# telemetry.json, a Chrome trace of the commands and the memory of those running at the same time.
+ifndef TP_TELEMETRY_CMD
+TP_TELEMETRY_CMD = $(ROOT)$(BUILD_DIR)tpTelemetry
+TP_TELEMETRY_SRC = $(ROOT)tp_build/tp_telemetry/tp_telemetry.cpp
+TP_TELEMETRY_LOG = $(ROOT)$(BUILD_DIR)telemetry.log
+TP_TELEMETRY_TOP ?= 10
+
+ifdef TP_TELEMETRY
+TP_TELEMETRY_RUN = $(TP_TELEMETRY_CMD) run --log=$(TP_TELEMETRY_LOG) --
+TP_TELEMETRY_TOOL = $(TP_TELEMETRY_CMD)
+endif
+
+$(TP_TELEMETRY_CMD): $(TP_TELEMETRY_SRC)
+	$(MKDIR) $(@D)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_TELEMETRY_SRC) -o $(TP_TELEMETRY_CMD)
+
+.PHONY: telemetry-report
+telemetry-report: $(TP_TELEMETRY_CMD)
+	$(TP_TELEMETRY_CMD) report --top=$(TP_TELEMETRY_TOP) --trace=$(ROOT)$(BUILD_DIR)telemetry.json $(TP_TELEMETRY_LOG)
+endif
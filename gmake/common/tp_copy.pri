@@ -1,10 +1,17 @@
+include $(ROOT)tp_build/gmake/common/tp_copy_tool.pri
+
 TP_COPY_BUILD_FILES=$(addprefix $(ROOT)$(BUILD_DIR), $(TP_COPY))
 TP_COPY_BUILD_DIRS=$(sort $(dir $(TP_COPY_BUILD_FILES)))
 
+# Make can't see changes inside a directory so these always run tpCopy, which only copies the files
+# that changed.
+TP_COPY_TREES=$(addprefix $(ROOT)$(BUILD_DIR), $(patsubst %/.,%,$(wildcard $(addsuffix /.,$(TP_COPY)))))
+.PHONY: $(TP_COPY_TREES)
+
 tp_copy: $(TP_COPY_BUILD_FILES) 
 
-$(ROOT)$(BUILD_DIR)%: % $(TP_COPY_BUILD_DIRS)
-	cp $< $@
+$(ROOT)$(BUILD_DIR)%: % | $(TP_COPY_BUILD_DIRS) $(TP_COPY_CMD)
+	$(TP_COPY_CMD) $(TP_COPY_ARGS) $< $@
 
 $(TP_COPY_BUILD_DIRS):
 	$(MKDIR) $@
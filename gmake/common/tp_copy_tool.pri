@@ -0,0 +1,13 @@
+# tpCopy skips files that are already up to date and clones or hard links them where it can, so a
+# build with large TP_COPY data doesn't spend its time copying the same files again. Directories
+# are copied with a thread per CPU. TP_COPY_HARDLINK=1 hard links the files, a program that writes
+# to one of these also changes the source.
+ifndef TP_COPY_CMD
+TP_COPY_CMD = $(ROOT)$(BUILD_DIR)tpCopy
+TP_COPY_SRC = $(ROOT)tp_build/tp_copy/tp_copy.cpp
+TP_COPY_ARGS = $(if $(TP_COPY_HARDLINK),--hardlink)
+
+$(TP_COPY_CMD): $(TP_COPY_SRC)
+	$(MKDIR) $(@D)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_COPY_SRC) -o $(TP_COPY_CMD)
+endif
@@ -1,38 +1,143 @@
-# Bring in the dependencies tree 
+include $(ROOT)tp_build/gmake/emcc/profile.pri
+include $(ROOT)tp_build/gmake/common/modules.pri
+
+# Bring in the dependencies tree
 include $(ROOT)$(PROJECT_DIR)/dependencies.pri
 include $(ROOT)tp_build/gmake/parse_dependencies.pri
 
 BC = $(addsuffix .bc,$(addprefix $(ROOT)$(BUILD_DIR),$(UNIQUE_LIBRARIES)))
+SIDE_BC = $(addsuffix .bc,$(addprefix $(ROOT)$(BUILD_DIR),$(TP_EMCC_SIDE_MODULES)))
+SIDE_WASM = $(addsuffix .side.wasm,$(addprefix $(ROOT)$(BUILD_DIR),$(TP_EMCC_SIDE_MODULES)))
+MAIN_BC = $(filter-out $(SIDE_BC),$(BC))
 HTML = $(ROOT)$(BUILD_DIR)$(TARGET).html
+JS = $(ROOT)$(BUILD_DIR)$(TARGET).js
+WASM = $(ROOT)$(BUILD_DIR)$(TARGET).wasm
+DEFERRED_WASM = $(ROOT)$(BUILD_DIR)$(TARGET).deferred.wasm
+
+# The names used before the .js and .wasm were linked in one step, see TP_EMCC_LEGACY_OUTPUTS.
 JS_ONLY = $(ROOT)$(BUILD_DIR)$(TARGET).js_only.js
 WASM_ONLY = $(ROOT)$(BUILD_DIR)$(TARGET).wasm_only.wasm
 
-all: $(JS_ONLY) $(WASM_ONLY)
+WEB_DIR = $(ROOT)$(BUILD_DIR)web/
+WEB_LOADER = $(WEB_DIR)$(TARGET).loader.js
+
+all: $(JS) $(WASM) $(SIDE_WASM) $(WEB_LOADER) $(if $(TP_EMCC_LEGACY_OUTPUTS),$(JS_ONLY) $(WASM_ONLY))
+
+web: $(WEB_LOADER)
 
 js_only: $(JS_ONLY)
 
 wasm_only: $(WASM_ONLY)
 
-$(HTML): $(BUILD_DIR) $(SUBDIRS) force_look
-	$(CXX) $(LDFLAGS) $(BC) $(LIBS) -o $@
+# A single link writes both the .js loader and the .wasm it loads, it only runs when a .bc changes.
+# Older versions of make read &: as two rules and would link twice in parallel builds.
+ifeq ($(filter grouped-target,$(.FEATURES)),)
+$(error Emscripten builds need GNU make 4.3 or newer for grouped targets)
+endif
+$(JS) $(WASM) &: $(MAIN_BC) $(TP_WASM_SPLIT_PROFILE) | $(BUILD_DIR) $(SUBDIRS)
+	$(TP_TELEMETRY_RUN) $(CXX) $(LDFLAGS) $(MAIN_BC) $(LIBS) -Wl,-Map=$(WASM).map -o $(JS)
+	$(call tp_wasm_split,$(WASM),$(DEFERRED_WASM))
+	$(call tp_wasm_opt,$(WASM))
+	$(call tp_wasm_opt,$(DEFERRED_WASM))
+
+# Separate links for the old output names, <target>.js_only.js loads <target>.js_only.wasm and
+# <target>.wasm_only.wasm is a standalone wasm without the JS runtime.
+$(JS_ONLY): $(MAIN_BC) | $(BUILD_DIR) $(SUBDIRS)
+	$(TP_TELEMETRY_RUN) $(CXX) $(filter-out -sSPLIT_MODULE,$(LDFLAGS)) $(MAIN_BC) $(LIBS) -o $@
+	$(call tp_wasm_opt,$(basename $@).wasm)
+
+$(WASM_ONLY): $(MAIN_BC) | $(BUILD_DIR) $(SUBDIRS)
+	$(TP_TELEMETRY_RUN) $(CXX) $(filter-out -sSPLIT_MODULE,$(LDFLAGS)) $(MAIN_BC) $(LIBS) -o $@
+	$(call tp_wasm_opt,$@)
+
+# Side modules are linked on their own and resolve everything else against the main module.
+$(ROOT)$(BUILD_DIR)%.side.wasm: $(ROOT)$(BUILD_DIR)%.bc
+	$(TP_TELEMETRY_RUN) $(CXX) $(filter-out -sMAIN_MODULE=% -sSPLIT_MODULE -sPTHREAD_POOL_SIZE=%,$(LDFLAGS)) -sSIDE_MODULE=1 $< -Wl,-Map=$@.map -o $@
+	$(call tp_wasm_opt,$@)
+
+# With TP_WASM_SPLIT and no profile the <target>.wasm written by emcc is already instrumented, load
+# the app to record a profile for TP_WASM_SPLIT_PROFILE.
+ifneq ($(TP_WASM_SPLIT),)
+ifeq ($(TP_WASM_SPLIT_PROFILE),)
+wasm-split-instrument: $(WASM)
+endif
+endif
+wasm-split-instrument:
+	$(if $(TP_WASM_SPLIT_PROFILE)$(if $(TP_WASM_SPLIT),,1),@echo "error: Run with TP_WASM_SPLIT=1 and without TP_WASM_SPLIT_PROFILE." >&2; exit 1)
+
+# Content hashed and precompressed copies of the link output for serving, see tp_web/package_web.sh.
+$(WEB_LOADER): $(JS) $(WASM) $(SIDE_WASM) $(ROOT)tp_build/tp_web/package_web.sh
+	bash $(ROOT)tp_build/tp_web/package_web.sh $(WEB_DIR) $(TARGET) $(JS) $(WASM) $(SIDE_WASM) $(wildcard $(DEFERRED_WASM) $(ROOT)$(BUILD_DIR)$(TARGET).data $(ROOT)$(BUILD_DIR)$(TARGET).worker.js)
+
+$(HTML): $(BC) | $(BUILD_DIR) $(SUBDIRS)
+	$(TP_TELEMETRY_RUN) $(CXX) $(LDFLAGS) $(BC) $(LIBS) -o $@
+	$(call tp_wasm_opt,$(basename $@).wasm)
+
+$(BUILD_DIR):
+	$(MKDIR) $(BUILD_DIR)
 
-$(JS_ONLY): $(BUILD_DIR) $(SUBDIRS) force_look
-	$(CXX) $(LDFLAGS) $(BC) $(LIBS) -o $@
+# Builds the emscripten system libraries needed by the current profile into EM_CACHE by linking an
+# empty program with the same flags, run this once when preparing a build agent.
+em-cache: | $(BUILD_DIR)
+	echo "int main(){return 0;}" > $(ROOT)$(BUILD_DIR)em_cache.cpp
+	$(CXX) $(CFLAGS) $(CXXFLAGS) $(LDFLAGS) $(ROOT)$(BUILD_DIR)em_cache.cpp -o $(ROOT)$(BUILD_DIR)em_cache.js
 
-$(WASM_ONLY): $(BUILD_DIR) $(SUBDIRS) force_look
-	$(CXX) $(LDFLAGS) $(BC) $(LIBS) -o $@
+# Each object gets a .d file listing the headers it includes so that header changes rebuild it.
+DEPFLAGS = -MMD -MP -MF $@.d
 
-$(BUILD_DIR): 
-	$(MKDIR) $(BUILD_DIR) 
+TP_RC_CMD = $(ROOT)$(BUILD_DIR)tp_rc
+TP_RC_SRC = $(ROOT)tp_build/tp_rc/tp_rc.cpp
 
-$(SUBDIRS): force_look
-	for d in $@ ; do (cd $$d ; $(MAKE) ) ; done
+# Every module adds its objects and archive to one build graph so that -j builds objects from
+# different modules in parallel and a build with nothing to do doesn't visit each module.
+define TP_MODULE_RULES
+$(1)_OBJECTS := $(addprefix $(call tp_module_obj_dir,$(1)),$(addsuffix .bc,$(filter %.c %.cpp,$($(1)_SOURCES))))
+$(1)_OBJECTS += $(addprefix $(call tp_module_obj_dir,$(1)),$(addsuffix .cpp.bc,$(filter %.qrc,$($(1)_TP_RC))))
+$(1)_BUILD_DIRS := $(sort $(addprefix $(call tp_module_obj_dir,$(1)),$(dir $($(1)_SOURCES) $($(1)_TP_RC))))
+$(1)_FLAGS := $(call tp_module_includes,$(1)) $(call tp_module_defines,$(1))
+$(1)_OUTPUT := $(ROOT)$(BUILD_DIR)$($(1)_TARGET).bc
+
+$$($(1)_OUTPUT): $$($(1)_OBJECTS)
+	$$(TP_TELEMETRY_RUN) "$(AR)" -r $$^ -o $$@
+
+$$($(1)_OBJECTS): | $$($(1)_BUILD_DIRS)
+$$($(1)_OBJECTS) $$($(1)_OUTPUT): | $$(TP_TELEMETRY_TOOL)
+
+$(call tp_module_obj_dir,$(1))%.c.bc: $(call tp_module_dir,$(1))%.c
+	$$(TP_TELEMETRY_RUN) "$(CC)" -c $$(DEPFLAGS) $($(1)_CFLAGS) $($(1)_CCFLAGS) $$($(1)_FLAGS) $$< -o $$@
+
+$(call tp_module_obj_dir,$(1))%.cpp.bc: $(call tp_module_dir,$(1))%.cpp
+	$$(TP_TELEMETRY_RUN) "$(CXX)" -c $$(DEPFLAGS) $($(1)_CFLAGS) $($(1)_CXXFLAGS) $$($(1)_FLAGS) $$< -o $$@
+
+# tpRc lists the files embedded in the resource in a .dep file, these are added to the .d file.
+$(call tp_module_obj_dir,$(1))%.qrc.cpp.bc: $(call tp_module_dir,$(1))%.qrc $(TP_RC_CMD)
+	$$(TP_TELEMETRY_RUN) "$(TP_RC_CMD)" "$$<" "$$(basename $$@)" $$(notdir $$*)
+	$$(TP_TELEMETRY_RUN) "$(CXX)" -c $$(DEPFLAGS) $($(1)_CFLAGS) $($(1)_CXXFLAGS) $$($(1)_FLAGS) "$$(basename $$@)" -o $$@
+	sed -e 's|^|$$@: |' "$$(basename $$@).dep" >> $$@.d
+	sed -e 's|$$$$|:|' "$$(basename $$@).dep" >> $$@.d
+
+$$($(1)_BUILD_DIRS):
+	$(MKDIR) $$@
+
+.PHONY: $(1)
+$(1): $$($(1)_OUTPUT) $$($(1)_EXTRAS)
+
+-include $$(addsuffix .d,$$($(1)_OBJECTS))
+endef
+$(foreach m,$(SUBDIRS),$(eval $(call TP_MODULE_EXTRAS,$(m))))
+$(foreach m,$(SUBDIRS),$(eval $(call TP_MODULE_RULES,$(m))))
+
+$(TP_RC_CMD): $(TP_RC_SRC)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_RC_SRC) -o $(TP_RC_CMD)
+
+# The maps are from before wasm-opt, the files show the size that is downloaded.
+TP_SIZE_NAME = $(TARGET)
+TP_SIZE_MAPS = $(WASM).map $(addsuffix .map,$(SIDE_WASM))
+TP_SIZE_FILES = $(WASM) $(SIDE_WASM) $(JS)
+include $(ROOT)tp_build/gmake/common/size.pri
 
 install:
 	-for d in $(SUBDIRS) ; do (cd $$d; $(MAKE) install ); done
 
 clean:
 	-for d in $(SUBDIRS); do (cd $$d; $(MAKE) clean ); done
-
-force_look :
-	true
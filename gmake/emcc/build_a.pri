@@ -1,3 +1,5 @@
+include $(ROOT)tp_build/gmake/emcc/profile.pri
+
 #Sort to remove duplicates
 BUILD_DIRS = $(sort $(addprefix $(ROOT)$(BUILD_DIR)$(TARGET)/,$(dir $(SOURCES))))
 
@@ -9,6 +11,10 @@ QRCOBJECTS = $(filter %.bc,$(QRCSOURCES:.cpp=.cpp.bc))
 DEFINES  := $(foreach DEFINE,$(DEFINES),-D$(DEFINE))
 INCLUDES += $(foreach INCLUDE,$(INCLUDEPATHS),-I../$(INCLUDE))
 
+# Each object gets a .d file listing the headers it includes so that header changes rebuild it.
+DEPFLAGS = -MMD -MP -MF $@.d
+-include $(addsuffix .d,$(CCOBJECTS) $(CXXOBJECTS) $(QRCOBJECTS))
+
 TP_RC_CMD = $(ROOT)$(BUILD_DIR)tp_rc
 TP_RC_SRC = $(ROOT)tp_build/tp_rc/tp_rc.cpp
 
@@ -18,14 +24,17 @@ $(ROOT)$(BUILD_DIR)$(TARGET).bc: $(CCOBJECTS) $(CXXOBJECTS) $(QRCOBJECTS)
 	"$(AR)" -r $^ -o $@
 
 $(ROOT)$(BUILD_DIR)$(TARGET)/%.c.bc: %.c
-	"$(CC)" -c $(CFLAGS) $(CCFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
+	"$(CC)" -c $(DEPFLAGS) $(CFLAGS) $(CCFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
 
 $(ROOT)$(BUILD_DIR)$(TARGET)/%.cpp.bc: %.cpp
-	"$(CXX)" -c $(CFLAGS) $(CXXFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
+	"$(CXX)" -c $(DEPFLAGS) $(CFLAGS) $(CXXFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
 
+# tpRc lists the files embedded in the resource in a .dep file, these are added to the .d file.
 $(ROOT)$(BUILD_DIR)$(TARGET)/%.qrc.cpp.bc: %.qrc $(TP_RC_CMD)
 	"$(TP_RC_CMD)" "$<" "$(basename $@)" $(basename $(basename $(notdir $<)))
-	"$(CXX)" -c $(CFLAGS) $(CXXFLAGS) $(INCLUDES) $(DEFINES) "$(basename $@)" -o $@
+	"$(CXX)" -c $(DEPFLAGS) $(CFLAGS) $(CXXFLAGS) $(INCLUDES) $(DEFINES) "$(basename $@)" -o $@
+	sed -e 's|^|$@: |' "$(basename $@).dep" >> $@.d
+	sed -e 's|$$|:|' "$(basename $@).dep" >> $@.d
 
 $(BUILD_DIRS):
 	$(MKDIR) $@
@@ -0,0 +1,77 @@
+# Emscripten build profiles, set these in project.inc or on the command line.
+#   make TP_EMCC_PROFILE=release TP_EMCC_SIMD=1 TP_EMCC_THREADS=4
+#
+# TP_EMCC_PROFILE  - release (-O3), size (-Oz) or debug (-O0 -g), empty uses the emcc defaults.
+# TP_EMCC_SIMD     - Compile with wasm SIMD (-msimd128), the browser must support it.
+# TP_EMCC_THREADS  - Build with pthreads and create a pool of this many workers at start up. The page
+#                    must be served cross origin isolated for SharedArrayBuffer to be available.
+# TP_WASM_OPT      - wasm-opt flags for an extra pass over the linked .wasm, empty disables it.
+# TP_EM_CACHE      - Directory used as EM_CACHE, share this between builds and CI agents so that the
+#                    emscripten system libraries are only built once, see the em-cache target.
+#
+# Code splitting, the startup critical code ships in <target>.wasm and the rest is fetched on demand.
+# TP_EMCC_SIDE_MODULES  - Libraries to build as side modules (<lib>.side.wasm) instead of linking them
+#                         into the app, load them with emscripten_dlopen when they are needed.
+# TP_EMCC_MAIN_MODULE   - MAIN_MODULE mode used with side modules, 1 exports everything (default) and
+#                         2 only what is used, which is smaller but needs EXPORTED_FUNCTIONS.
+# TP_WASM_SPLIT         - Link with -sSPLIT_MODULE, emcc then writes an instrumented <target>.wasm that
+#                         records which functions run at start up and the original as .wasm.orig.
+# TP_WASM_SPLIT_PROFILE - The profile written by the instrumented wasm, functions that are not in it
+#                         are moved into <target>.deferred.wasm which is loaded when first called.
+
+WASM_OPT ?= wasm-opt
+WASM_SPLIT ?= wasm-split
+
+ifeq ($(TP_EMCC_PROFILE), release)
+CFLAGS += -O3
+LDFLAGS += -O3
+TP_WASM_OPT ?= -O3 --converge
+endif
+
+ifeq ($(TP_EMCC_PROFILE), size)
+CFLAGS += -Oz
+LDFLAGS += -Oz
+TP_WASM_OPT ?= -Oz --converge
+endif
+
+ifeq ($(TP_EMCC_PROFILE), debug)
+CFLAGS += -O0 -g
+LDFLAGS += -O0 -g -sASSERTIONS=1
+endif
+
+ifdef TP_EMCC_SIMD
+CFLAGS += -msimd128
+LDFLAGS += -msimd128
+TP_WASM_OPT_FEATURES += --enable-simd
+endif
+
+ifdef TP_EMCC_THREADS
+CFLAGS += -pthread
+LDFLAGS += -pthread -sPTHREAD_POOL_SIZE=$(TP_EMCC_THREADS)
+TP_WASM_OPT_FEATURES += --enable-threads --enable-bulk-memory
+endif
+
+ifneq ($(TP_EMCC_SIDE_MODULES),)
+TP_EMCC_MAIN_MODULE ?= 1
+CFLAGS += -fPIC
+LDFLAGS += -sMAIN_MODULE=$(TP_EMCC_MAIN_MODULE)
+endif
+
+ifdef TP_WASM_SPLIT_PROFILE
+TP_WASM_SPLIT = 1
+endif
+
+ifdef TP_WASM_SPLIT
+LDFLAGS += -sSPLIT_MODULE
+endif
+
+ifdef TP_EM_CACHE
+export EM_CACHE=$(abspath $(TP_EM_CACHE))
+endif
+
+# Runs wasm-opt in place on a linked .wasm file if it exists.
+tp_wasm_opt = $(if $(TP_WASM_OPT),if [ -f "$(1)" ]; then "$(WASM_OPT)" $(TP_WASM_OPT) $(TP_WASM_OPT_FEATURES) "$(1)" -o "$(1)"; fi)
+
+# Splits the original module written by -sSPLIT_MODULE (<target>.wasm.orig) in to the primary .wasm,
+# which replaces the instrumented one, and a deferred .wasm with the functions not in the profile.
+tp_wasm_split = $(if $(TP_WASM_SPLIT_PROFILE),"$(WASM_SPLIT)" --export-prefix=% --enable-mutable-globals $(TP_WASM_OPT_FEATURES) --profile="$(TP_WASM_SPLIT_PROFILE)" "$(1).orig" -o1 "$(1)" -o2 "$(2)")
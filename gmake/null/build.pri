@@ -1,3 +1,5 @@
+include $(ROOT)tp_build/gmake/common/modules.pri
+
 UNIQUE_LIBRARIES = $(call uniq,$(LIBRARIES))
 
 SUB_AR = $(addsuffix .a,$(addprefix $(ROOT)$(BUILD_DIR),$(UNIQUE_LIBRARIES)))
@@ -11,15 +13,19 @@ OBJ_DIR = $(ROOT)$(BUILD_DIR)/obj/
 all: $(BUILD_DIR) $(SUBDIRS)
 
 $(PUB_AR): $(BUILD_DIR) $(SUBDIRS) $(SUB_AR)
-	"$(LD)" --whole-archive -r $(SUB_AR) -o $(PUB_O)
-	"$(AR)" rcs $@ $(PUB_O)
+	$(TP_TELEMETRY_RUN) "$(LD)" --whole-archive -r $(SUB_AR) -o $(PUB_O)
+	$(TP_TELEMETRY_RUN) "$(AR)" rcs $@ $(PUB_O)
 
 $(BUILD_DIR): 
 	$(MKDIR) $(BUILD_DIR) 
 
-.PHONY: force_look
-$(SUBDIRS): force_look
-	for d in $@ ; do (cd $$d ; make  ) ; done
+# Modules only generate pages and copy files in this build.
+define TP_MODULE_RULES
+.PHONY: $(1)
+$(1): $$($(1)_EXTRAS)
+endef
+$(foreach m,$(SUBDIRS),$(eval $(call TP_MODULE_EXTRAS,$(m))))
+$(foreach m,$(SUBDIRS),$(eval $(call TP_MODULE_RULES,$(m))))
 
 install:
 	-for d in $(SUBDIRS) ; do (cd $$d; $(MAKE) install ); done
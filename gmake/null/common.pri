@@ -1,3 +1,4 @@
 
 RM=rm -Rf
 MKDIR=mkdir -p
+HOST_CXX=g++
@@ -1,3 +1,6 @@
+include $(ROOT)tp_build/gmake/sdcc/profile.pri
+include $(ROOT)tp_build/gmake/common/modules.pri
+
 # Bring in the dependencies tree 
 include $(ROOT)$(PROJECT_DIR)/dependencies.pri
 include $(ROOT)tp_build/gmake/parse_dependencies.pri
@@ -7,23 +10,58 @@ INCLUDES += $(foreach INCLUDE,$(INCLUDEPATHS),-I./$(INCLUDE))
 
 DEFINES += -DTP_SDCC
 
-ARCHIVES = $(addsuffix .lib,$(addprefix $(ROOT)$(BUILD_DIR),$(SUBDIRS)))
+ARCHIVES = $(foreach m,$(SUBDIRS),$(ROOT)$(BUILD_DIR)$($(m)_TARGET).lib)
 HEX = $(ROOT)$(BUILD_DIR)$(TARGET).hex
 BIN = $(ROOT)$(BUILD_DIR)$(TARGET).bin
 
 all: $(BIN) $(HEX)
 
-$(HEX): $(BUILD_DIR) $(SUBDIRS) $(ARCHIVES)
-	$(CC) $(LDFLAGS) $(ROOT)$(MAIN_SRC) $(ARCHIVES) $(LIBS) $(INCLUDES) $(DEFINES) -o $@
+$(HEX): $(ARCHIVES) | $(BUILD_DIR) $(SUBDIRS)
+	$(TP_TELEMETRY_RUN) $(CC) $(LDFLAGS) $(ROOT)$(MAIN_SRC) $(ARCHIVES) $(LIBS) $(INCLUDES) $(DEFINES) -o $@
 
 $(BIN): $(HEX)
-	$(MAKEBIN) -p $< $@
+	$(TP_TELEMETRY_RUN) $(MAKEBIN) -p $< $@
 
 $(BUILD_DIR):
 	$(MKDIR) $(BUILD_DIR)
 
-$(SUBDIRS): force_look
-	for d in $@ ; do (cd $$d ; make ) ; done
+# Every module adds its objects and archive to one build graph so that -j builds objects from
+# different modules in parallel and a build with nothing to do doesn't visit each module.
+define TP_MODULE_RULES
+$(1)_OBJECTS := $(addprefix $(call tp_module_obj_dir,$(1)),$(patsubst %.S,%.rel,$(patsubst %.c,%.rel,$(filter %.S %.c,$($(1)_SOURCES)))))
+$(1)_BUILD_DIRS := $(sort $(addprefix $(call tp_module_obj_dir,$(1)),$(dir $($(1)_SOURCES))))
+$(1)_FLAGS := $(call tp_module_includes,$(1)) $(call tp_module_defines,$(1)) -DTP_SDCC
+$(1)_OUTPUT := $(ROOT)$(BUILD_DIR)$($(1)_TARGET).lib
+
+$$($(1)_OUTPUT): $$($(1)_OBJECTS)
+	$$(TP_TELEMETRY_RUN) "$(AR)" -rc $$@ $$^
+
+$$($(1)_OBJECTS): | $$($(1)_BUILD_DIRS)
+$$($(1)_OBJECTS) $$($(1)_OUTPUT): | $$(TP_TELEMETRY_TOOL)
+
+$(call tp_module_obj_dir,$(1))%.rel: $(call tp_module_dir,$(1))%.S $(ASM_PART)
+	$$(TP_TELEMETRY_RUN) "$(AS)" -c $($(1)_CFLAGS) $($(1)_CCFLAGS) $$($(1)_FLAGS) $$< -o $$@
+
+$(call tp_module_obj_dir,$(1))%.rel: $(call tp_module_dir,$(1))%.c
+	$$(TP_TELEMETRY_RUN) "$(CC)" -c $($(1)_CFLAGS) $($(1)_CCFLAGS) $$($(1)_FLAGS) $$< -o $$@
+
+$$($(1)_BUILD_DIRS):
+	$(MKDIR) $$@
+
+.PHONY: $(1)
+$(1): $$($(1)_OUTPUT) $$($(1)_EXTRAS)
+endef
+$(foreach m,$(SUBDIRS),$(eval $(call TP_MODULE_EXTRAS,$(m))))
+$(foreach m,$(SUBDIRS),$(eval $(call TP_MODULE_RULES,$(m))))
+
+# SDCC writes the map next to the hex file.
+TP_SIZE_NAME = $(TARGET)
+TP_SIZE_MAPS = $(ROOT)$(BUILD_DIR)$(TARGET).map
+TP_SIZE_FILES = $(BIN)
+TP_SIZE_MEMORY = 1
+include $(ROOT)tp_build/gmake/common/size.pri
+
+all: $(TP_SIZE_CHECK)
 
 install:
 	-for d in $(SUBDIRS) ; do (cd $$d; $(MAKE) install ); done
@@ -31,6 +69,3 @@ install:
 clean:
 	-for d in $(SUBDIRS); do (cd $$d; $(MAKE) clean ); done
 
-force_look :
-	true
-
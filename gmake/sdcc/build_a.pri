@@ -1,3 +1,5 @@
+include $(ROOT)tp_build/gmake/sdcc/profile.pri
+
 #Sort to remove duplicates
 BUILD_DIRS = $(sort $(addprefix $(ROOT)$(BUILD_DIR)$(TARGET)/,$(dir $(SOURCES))))
 
@@ -4,4 +4,5 @@ AS = $(CROSS_COMPILE)sdcc
 MAKEBIN = $(CROSS_COMPILE)makebin
 RM=rm -rf
 MKDIR=mkdir -p
+HOST_CXX=g++
 
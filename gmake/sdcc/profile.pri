@@ -0,0 +1,13 @@
+# SDCC build profiles, set these in project.conf or on the command line.
+#   make TP_UC_PROFILE=size
+#
+# TP_UC_PROFILE - size (--opt-code-size), empty uses the toolchain flags. SDCC links whole modules
+#                 and has no LTO, so keep rarely used functions in their own source files.
+#
+# The flash and RAM used by each module are checked against TP_FLASH_BUDGETS and TP_RAM_BUDGETS
+# after every link, see common/size.pri.
+
+ifeq ($(TP_UC_PROFILE), size)
+CFLAGS += --opt-code-size
+LDFLAGS += --opt-code-size
+endif
@@ -1,22 +1,147 @@
+include $(ROOT)tp_build/gmake/common/sanitize.pri
+include $(ROOT)tp_build/gmake/common/stack_usage.pri
+include $(ROOT)tp_build/gmake/common/build_times.pri
+include $(ROOT)tp_build/gmake/common/build_cache.pri
+include $(ROOT)tp_build/gmake/common/modules.pri
+
 all: $(SUBDIRS)
 
 $(BUILD_DIR): 
 	$(MKDIR) $(BUILD_DIR) 
 
-define BUILD_SUBDIR
-DEPENDENCIES:=
-$(eval -include $(ROOT)$(1)/dependencies.pri)
-$(info Target: $(1) Dependencies: $(DEPENDENCIES))
-$(1): $(BUILD_DIR) $(DEPENDENCIES) force_look
-	cd $(1);$$(MAKE)
+# Each object gets a .d file listing the headers it includes so that header changes rebuild it.
+DEPFLAGS = -MMD -MP -MF $@.d
+
+# Every module adds its objects, archive or executable to one build graph so that -j builds objects
+# from different modules in parallel and a build with nothing to do doesn't visit each module.
+define TP_MODULE_RULES
+$(1)_OBJECTS := $(addprefix $(call tp_module_obj_dir,$(1)),$(addsuffix .o,$(filter %.c %.cpp,$($(1)_SOURCES))))
+$(1)_BUILD_DIRS := $(sort $(addprefix $(call tp_module_obj_dir,$(1)),$(dir $($(1)_SOURCES))))
+$(1)_FLAGS := $(call tp_module_includes,$(1)) $(call tp_module_defines,$(1))
+
+$(1)_LIBS := $(foreach LIB,$($(1)_LIBS),-l$(LIB))
+$(1)_LIBS := $$(patsubst -l-l%,-l%,$$(patsubst -l-L%,-L%,$$($(1)_LIBS)))
+$(1)_LIBS += $(patsubst -L$(ROOT)/%,-L/%,$(addprefix -L$(ROOT),$($(1)_LIBRARYPATHS)))
+$(1)_LIBS += $(foreach LIB,$($(1)_LIBRARIES),$(ROOT)$(BUILD_DIR)$(LIB).a)
+
+ifneq ($(filter app test bench,$($(1)_TEMPLATE)),)
+$(1)_OUTPUT := $(call tp_module_obj_dir,$(1))$($(1)_TARGET)
+$$($(1)_OUTPUT): $$($(1)_OBJECTS) $(foreach LIB,$(filter $(TP_LIB_TARGETS),$($(1)_LIBRARIES)),$(ROOT)$(BUILD_DIR)$(LIB).a)
+	$$(TP_TIME) $$(TP_TELEMETRY_RUN) "$(CXX)" $$($(1)_OBJECTS) $$($(1)_LIBS) $($(1)_LFLAGS) -Wl,-Map=$$@.map -o $$@
+endif
+
+ifeq ($($(1)_TEMPLATE), lib)
+$(1)_OUTPUT := $(ROOT)$(BUILD_DIR)$($(1)_TARGET).a
+$$($(1)_OUTPUT): $$($(1)_OBJECTS)
+	$(RM) $$@
+	$$(TP_TIME) $$(TP_TELEMETRY_RUN) $$(call tp_cache,$(1)) "$(AR)" rcs $$@ $$^
+endif
+
+$$($(1)_OBJECTS): | $$($(1)_BUILD_DIRS)
+$$($(1)_OBJECTS) $$($(1)_OUTPUT): | $$(TP_TELEMETRY_TOOL)
+
+ifdef TP_CACHE_DIR
+$$($(1)_OBJECTS) $$($(1)_OUTPUT): | $(TP_CACHE_CMD)
+endif
+
+$(call tp_module_obj_dir,$(1))%.c.o: $(call tp_module_dir,$(1))%.c
+	$$(TP_TIME) $$(TP_TELEMETRY_RUN) $$(call tp_cache,$(1)) "$(CC)" -c $$(DEPFLAGS) $($(1)_CFLAGS) $($(1)_CCFLAGS) $$($(1)_FLAGS) $$< -o $$@
+
+$(call tp_module_obj_dir,$(1))%.cpp.o: $(call tp_module_dir,$(1))%.cpp
+	$$(TP_TIME) $$(TP_TELEMETRY_RUN) $$(call tp_cache,$(1)) "$(CXX)" -c $$(DEPFLAGS) $($(1)_CFLAGS) $($(1)_CXXFLAGS) $$($(1)_FLAGS) $$< -o $$@
+
+$$($(1)_BUILD_DIRS):
+	$(MKDIR) $$@
+
+.PHONY: $(1)
+$(1): $$($(1)_OUTPUT) $$($(1)_EXTRAS)
+
+-include $$(addsuffix .d,$$($(1)_OBJECTS))
 endef
-$(foreach i,$(SUBDIRS),$(eval $(call BUILD_SUBDIR,$(i))))
+$(foreach m,$(SUBDIRS),$(eval $(call TP_MODULE_EXTRAS,$(m))))
+$(foreach m,$(SUBDIRS),$(eval $(call TP_MODULE_RULES,$(m))))
+
+ifdef TP_PERF_COUNTERS
+BENCH_ARGS += --perf-counters
+endif
+
+ifdef TP_BENCH_PIN_CPU
+BENCH_ARGS += --pin-cpu=$(TP_BENCH_PIN_CPU)
+endif
+
+# Benchmarks run one at a time even with -j so that they don't disturb each other.
+TP_BENCH_TARGETS = $(foreach m,$(SUBDIRS),$(if $(filter bench,$($(m)_TEMPLATE)),$($(m)_TARGET)))
 
 install:
 	-for d in $(SUBDIRS) ; do (cd $$d; $(MAKE) install ); done
 
+benchmarks: all
+	$(MKDIR) $(ROOT)$(BUILD_DIR)bench_results
+	for t in $(TP_BENCH_TARGETS) ; do $(ROOT)$(BUILD_DIR)$$t/$$t --json=$(ROOT)$(BUILD_DIR)bench_results/$$t.json $(BENCH_ARGS) || exit 1; done
+
+TP_BENCH_MACHINE ?= $(shell hostname)
+TP_BENCH_BASELINE_DIR ?= $(ROOT)$(PROJECT_DIR)/bench_baselines
+TP_BENCH_THRESHOLD ?= 5
+TP_BENCH_ALPHA ?= 0.01
+
+TP_BENCH_CHECK_CMD = $(ROOT)$(BUILD_DIR)tpBenchCheck
+TP_BENCH_CHECK_SRC = $(ROOT)tp_build/tp_bench/tp_bench_check.cpp
+
+bench-check: benchmarks $(TP_BENCH_CHECK_CMD)
+	$(TP_BENCH_CHECK_CMD) --threshold=$(TP_BENCH_THRESHOLD) --alpha=$(TP_BENCH_ALPHA) $(TP_BENCH_BASELINE_DIR)/$(TP_BENCH_MACHINE) $(ROOT)$(BUILD_DIR)bench_results
+
+bench-baseline: benchmarks $(TP_BENCH_CHECK_CMD)
+	$(TP_BENCH_CHECK_CMD) --update $(TP_BENCH_BASELINE_DIR)/$(TP_BENCH_MACHINE) $(ROOT)$(BUILD_DIR)bench_results
+
+$(TP_BENCH_CHECK_CMD): $(TP_BENCH_CHECK_SRC)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_BENCH_CHECK_SRC) -o $(TP_BENCH_CHECK_CMD)
+
+# Build with TP_PROF=1 then: make profile PROFILE_TARGET=<app or bench> PROFILE_ARGS=...
+TP_FLAMEGRAPH_CMD = $(ROOT)$(BUILD_DIR)tpFlameGraph
+TP_FLAMEGRAPH_SRC = $(ROOT)tp_build/tp_prof/tp_flamegraph.cpp
+
+profile: all $(TP_FLAMEGRAPH_CMD)
+	bash $(ROOT)tp_build/tp_prof/profile.sh $(TP_FLAMEGRAPH_CMD) $(ROOT)$(BUILD_DIR)profile $(ROOT)$(BUILD_DIR)$(PROFILE_TARGET)/$(PROFILE_TARGET) $(PROFILE_ARGS)
+
+$(TP_FLAMEGRAPH_CMD): $(TP_FLAMEGRAPH_SRC)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_FLAMEGRAPH_SRC) -o $(TP_FLAMEGRAPH_CMD)
+
+# make size-report SIZE_TARGET=<app, test or bench>, defaults to the project target.
+SIZE_TARGET ?= $(TARGET)
+TP_SIZE_NAME = $(SIZE_TARGET)
+TP_SIZE_MAPS = $(ROOT)$(BUILD_DIR)$(SIZE_TARGET)/$(SIZE_TARGET).map
+TP_SIZE_FILES = $(ROOT)$(BUILD_DIR)$(SIZE_TARGET)/$(SIZE_TARGET)
+include $(ROOT)tp_build/gmake/common/size.pri
+
+# Build with TP_STACK_USAGE=1 then: make stack-report STACK_TARGET=<app, test or bench>
+STACK_TARGET ?= $(TARGET)
+TP_STACK_MODULE = $(firstword $(foreach m,$(SUBDIRS),$(if $(filter $(STACK_TARGET),$($(m)_TARGET)),$(m))))
+TP_STACK_DIRS = $(foreach m,$(SUBDIRS),$(if $(filter $($(m)_TARGET),$(STACK_TARGET) $($(TP_STACK_MODULE)_LIBRARIES)),$(call tp_module_obj_dir,$(m))))
+
+stack-report: all $(TP_STACK_USAGE_CMD)
+	$(TP_STACK_USAGE_CMD) $(TP_STACK_USAGE_ARGS) $(TP_STACK_DIRS)
+
+$(TP_STACK_USAGE_CMD): $(TP_STACK_USAGE_SRC)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_STACK_USAGE_SRC) -o $(TP_STACK_USAGE_CMD)
+
+# Build with TP_BUILD_TIMES=1 then: make critical-path
+critical-path: $(TP_CRITICAL_PATH_CMD)
+	$(TP_CRITICAL_PATH_CMD) --build-dir=$(ROOT)$(BUILD_DIR) --trace=$(ROOT)$(BUILD_DIR)critical_path.json $(TP_CRITICAL_PATH_MODULES) $(ROOT)$(BUILD_DIR)build_times.log
+
+$(TP_CRITICAL_PATH_CMD): $(TP_CRITICAL_PATH_SRC)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_CRITICAL_PATH_SRC) -o $(TP_CRITICAL_PATH_CMD)
+
+$(TP_CACHE_CMD): $(TP_CACHE_SRC)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_CACHE_SRC) -o $(TP_CACHE_CMD)
+
+# make cache-stats TP_CACHE_DIR=... or make cache-trim TP_CACHE_DIR=... TP_CACHE_MAX_SIZE=5G
+TP_CACHE_MAX_SIZE ?= 5G
+
+cache-stats: $(TP_CACHE_CMD)
+	$(TP_CACHE_CMD) stats --cache-dir=$(TP_CACHE_DIR)
+
+cache-trim: $(TP_CACHE_CMD)
+	$(TP_CACHE_CMD) trim --cache-dir=$(TP_CACHE_DIR) --max-size=$(TP_CACHE_MAX_SIZE)
+
 clean:
 	-for d in $(SUBDIRS); do (cd $$d; $(MAKE) clean ); done
-
-force_look :
-	true
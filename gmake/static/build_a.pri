@@ -1,9 +1,16 @@
+include $(ROOT)tp_build/gmake/common/sanitize.pri
+include $(ROOT)tp_build/gmake/common/stack_usage.pri
+
 #Sort to remove duplicates
 BUILD_DIRS = $(sort $(addprefix $(ROOT)$(BUILD_DIR)$(TARGET)/,$(dir $(SOURCES))))
 
 CCOBJECTS = $(filter %.o,$(SOURCES:.c=.c.o))
 CXXOBJECTS = $(filter %.o,$(SOURCES:.cpp=.cpp.o))
 
+# Each object gets a .d file listing the headers it includes so that header changes rebuild it.
+DEPFLAGS = -MMD -MP -MF $@.d
+-include $(addsuffix .d,$(addprefix $(ROOT)$(BUILD_DIR)$(TARGET)/,$(CCOBJECTS) $(CXXOBJECTS)))
+
 DEFINES  := $(foreach DEFINE,$(DEFINES),-D$(DEFINE))
 
 INCLUDES += $(foreach INCLUDE,$(INCLUDEPATHS),-I../$(INCLUDE))
@@ -17,7 +24,7 @@ LIBS += $(foreach LIB,$(LIBRARYPATHS),-L../$(LIB))
 LIBS := $(LIBS:-L..//%=-L/%) # Remove ../ from absolute paths
 LIBS += $(foreach LIB,$(LIBRARIES),$(ROOT)$(BUILD_DIR)$(LIB).a)
 
-ifeq ($(TEMPLATE), app)
+ifneq ($(filter app test bench,$(TEMPLATE)),)
 
 all_a: $(BUILD_DIRS) $(ROOT)$(BUILD_DIR)$(TARGET)/$(TARGET)
 
@@ -36,11 +43,31 @@ $(ROOT)$(BUILD_DIR)$(TARGET).a: $(addprefix $(ROOT)$(BUILD_DIR)$(TARGET)/,$(CCOB
 
 endif
 
+ifeq ($(TEMPLATE), bench)
+
+ifdef TP_PERF_COUNTERS
+BENCH_ARGS += --perf-counters
+endif
+
+ifdef TP_BENCH_PIN_CPU
+BENCH_ARGS += --pin-cpu=$(TP_BENCH_PIN_CPU)
+endif
+
+bench_a: all_a
+	$(MKDIR) $(ROOT)$(BUILD_DIR)bench_results
+	$(ROOT)$(BUILD_DIR)$(TARGET)/$(TARGET) --json=$(ROOT)$(BUILD_DIR)bench_results/$(TARGET).json $(BENCH_ARGS)
+
+else
+
+bench_a:
+
+endif
+
 $(ROOT)$(BUILD_DIR)$(TARGET)/%.c.o: %.c
-	"$(CC)" -c $(CFLAGS) $(CCFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
+	"$(CC)" -c $(DEPFLAGS) $(CFLAGS) $(CCFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
 
 $(ROOT)$(BUILD_DIR)$(TARGET)/%.cpp.o: %.cpp
-	"$(CXX)" -c $(CFLAGS) $(CXXFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
+	"$(CXX)" -c $(DEPFLAGS) $(CFLAGS) $(CXXFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
 
 $(BUILD_DIRS):
 	$(MKDIR) $@
@@ -8,6 +8,7 @@ LKELF = $(CROSS_COMPILE)g++
 OBJCOPY = $(CROSS_COMPILE)objcopy
 RM=rm -Rf
 MKDIR=mkdir -p
+HOST_CXX=g++
 
 CXXFLAGS += -std=c++1z
 LDFLAGS += -std=c++1z
@@ -1,4 +1,8 @@
-ARCHIVES = $(addsuffix .a,$(addprefix $(ROOT)$(BUILD_DIR),$(SUBDIRS)))
+include $(ROOT)tp_build/gmake/uc/profile.pri
+include $(ROOT)tp_build/gmake/common/stack_usage.pri
+include $(ROOT)tp_build/gmake/common/modules.pri
+
+ARCHIVES = $(foreach m,$(SUBDIRS),$(ROOT)$(BUILD_DIR)$($(m)_TARGET).a)
 ELF = $(ROOT)$(BUILD_DIR)$(TARGET).elf
 HEX = $(ROOT)$(BUILD_DIR)$(TARGET).hex
 BIN = $(ROOT)$(BUILD_DIR)$(TARGET).bin
@@ -6,19 +10,70 @@ BIN = $(ROOT)$(BUILD_DIR)$(TARGET).bin
 all: $(BIN) $(HEX)
 
 $(HEX): $(ELF)
-	$(OBJCOPY) -O ihex -R .eeprom $< $@
+	$(TP_TELEMETRY_RUN) $(OBJCOPY) -O ihex -R .eeprom $< $@
 
 $(BIN): $(ELF)
-	$(OBJCOPY) -O binary $< $@
+	$(TP_TELEMETRY_RUN) $(OBJCOPY) -O binary $< $@
 
-$(ELF): $(BUILD_DIR) $(SUBDIRS) $(ARCHIVES)
-	$(CXX) $(LDFLAGS) -Wl,--start-group $(ARCHIVES) $(LIBS) -Wl,--end-group -o $@
+$(ELF): $(ARCHIVES) | $(BUILD_DIR) $(SUBDIRS)
+	$(TP_TELEMETRY_RUN) $(CXX) $(LDFLAGS) -Wl,--start-group $(ARCHIVES) $(LIBS) -Wl,--end-group -Wl,-Map=$@.map -o $@
 
 $(BUILD_DIR): 
 	$(MKDIR) $(BUILD_DIR) 
 
-$(SUBDIRS): force_look
-	for d in $@ ; do (cd $$d ; make ) ; done
+# Each object gets a .d file listing the headers it includes so that header changes rebuild it.
+DEPFLAGS = -MMD -MP -MF $@.d
+
+# Every module adds its objects and archive to one build graph so that -j builds objects from
+# different modules in parallel and a build with nothing to do doesn't visit each module.
+define TP_MODULE_RULES
+$(1)_OBJECTS := $(addprefix $(call tp_module_obj_dir,$(1)),$(addsuffix .o,$(filter %.S %.c %.cpp,$($(1)_SOURCES))))
+$(1)_BUILD_DIRS := $(sort $(addprefix $(call tp_module_obj_dir,$(1)),$(dir $($(1)_SOURCES))))
+$(1)_FLAGS := $(call tp_module_includes,$(1)) $(call tp_module_defines,$(1))
+$(1)_OUTPUT := $(ROOT)$(BUILD_DIR)$($(1)_TARGET).a
+
+$$($(1)_OUTPUT): $$($(1)_OBJECTS)
+	$$(TP_TELEMETRY_RUN) "$(AR)" rcs $$@ $$^
+	$$(TP_TELEMETRY_RUN) "$(NM)" $$@ > $$@.txt
+
+$$($(1)_OBJECTS): | $$($(1)_BUILD_DIRS)
+$$($(1)_OBJECTS) $$($(1)_OUTPUT): | $$(TP_TELEMETRY_TOOL)
+
+$(call tp_module_obj_dir,$(1))%.S.o: $(call tp_module_dir,$(1))%.S $(ASM_PART)
+	$$(TP_TELEMETRY_RUN) "$(CPP)" $$(DEPFLAGS) -MT $$@ $$($(1)_FLAGS) $$< > $$@.s
+	$$(TP_TELEMETRY_RUN) "$(CC)" -c $($(1)_CFLAGS) $($(1)_CCFLAGS) $$($(1)_FLAGS) $$@.s -o $$@
+
+$(call tp_module_obj_dir,$(1))%.c.o: $(call tp_module_dir,$(1))%.c
+	$$(TP_TELEMETRY_RUN) "$(CC)" -c $$(DEPFLAGS) $($(1)_CFLAGS) $($(1)_CCFLAGS) $$($(1)_FLAGS) $$< -o $$@
+
+$(call tp_module_obj_dir,$(1))%.cpp.o: $(call tp_module_dir,$(1))%.cpp
+	$$(TP_TELEMETRY_RUN) "$(CXX)" -c $$(DEPFLAGS) $($(1)_CFLAGS) $($(1)_CXXFLAGS) $$($(1)_FLAGS) $$< -o $$@
+
+$$($(1)_BUILD_DIRS):
+	$(MKDIR) $$@
+
+.PHONY: $(1)
+$(1): $$($(1)_OUTPUT) $$($(1)_EXTRAS)
+
+-include $$(addsuffix .d,$$($(1)_OBJECTS))
+endef
+$(foreach m,$(SUBDIRS),$(eval $(call TP_MODULE_EXTRAS,$(m))))
+$(foreach m,$(SUBDIRS),$(eval $(call TP_MODULE_RULES,$(m))))
+
+TP_SIZE_NAME = $(TARGET)
+TP_SIZE_MAPS = $(ELF).map
+TP_SIZE_FILES = $(BIN)
+TP_SIZE_MEMORY = 1
+include $(ROOT)tp_build/gmake/common/size.pri
+
+all: $(TP_SIZE_CHECK)
+
+# Build with TP_STACK_USAGE=1 then: make stack-report
+stack-report: all $(TP_STACK_USAGE_CMD)
+	$(TP_STACK_USAGE_CMD) $(TP_STACK_USAGE_ARGS) $(foreach m,$(SUBDIRS),$(call tp_module_obj_dir,$(m)))
+
+$(TP_STACK_USAGE_CMD): $(TP_STACK_USAGE_SRC)
+	$(HOST_CXX) -std=gnu++1z -O2 $(TP_STACK_USAGE_SRC) -o $(TP_STACK_USAGE_CMD)
 
 install:
 	-for d in $(SUBDIRS) ; do (cd $$d; $(MAKE) install ); done
@@ -26,6 +81,3 @@ install:
 clean:
 	-for d in $(SUBDIRS); do (cd $$d; $(MAKE) clean ); done
 
-force_look :
-	true
-
@@ -1,3 +1,6 @@
+include $(ROOT)tp_build/gmake/uc/profile.pri
+include $(ROOT)tp_build/gmake/common/stack_usage.pri
+
 #Sort to remove duplicates
 BUILD_DIRS = $(sort $(addprefix $(ROOT)$(BUILD_DIR)$(TARGET)/,$(dir $(SOURCES))))
 
@@ -8,6 +11,10 @@ SOBJECTS = $(filter %.o,$(SOURCES:.S=.S.o))
 CCOBJECTS = $(filter %.o,$(SOURCES:.c=.c.o))
 CXXOBJECTS = $(filter %.o,$(SOURCES:.cpp=.cpp.o))
 
+# Each object gets a .d file listing the headers it includes so that header changes rebuild it.
+DEPFLAGS = -MMD -MP -MF $@.d
+-include $(addsuffix .d,$(addprefix $(ROOT)$(BUILD_DIR)$(TARGET)/,$(SOBJECTS) $(CCOBJECTS) $(CXXOBJECTS)))
+
 all_a: $(BUILD_DIRS) $(ROOT)$(BUILD_DIR)$(TARGET).a
 
 $(ROOT)$(BUILD_DIR)$(TARGET).a: $(addprefix $(ROOT)$(BUILD_DIR)$(TARGET)/,$(SOBJECTS)) $(addprefix $(ROOT)$(BUILD_DIR)$(TARGET)/,$(CCOBJECTS)) $(addprefix $(ROOT)$(BUILD_DIR)$(TARGET)/,$(CXXOBJECTS))
@@ -15,14 +22,14 @@ $(ROOT)$(BUILD_DIR)$(TARGET).a: $(addprefix $(ROOT)$(BUILD_DIR)$(TARGET)/,$(SOBJ
 	"$(NM)" $@ > $@.txt
 
 $(ROOT)$(BUILD_DIR)$(TARGET)/%.S.o: %.S $(ASM_PART)
-	"$(CPP)" $(INCLUDES) $(DEFINES) $< > $@.s
+	"$(CPP)" $(DEPFLAGS) -MT $@ $(INCLUDES) $(DEFINES) $< > $@.s
 	"$(CC)" -c $(CFLAGS) $(CCFLAGS) $(INCLUDES) $(DEFINES) $@.s -o $@
 
 $(ROOT)$(BUILD_DIR)$(TARGET)/%.c.o: %.c
-	"$(CC)" -c $(CFLAGS) $(CCFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
+	"$(CC)" -c $(DEPFLAGS) $(CFLAGS) $(CCFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
 
 $(ROOT)$(BUILD_DIR)$(TARGET)/%.cpp.o: %.cpp
-	"$(CXX)" -c $(CFLAGS) $(CXXFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
+	"$(CXX)" -c $(DEPFLAGS) $(CFLAGS) $(CXXFLAGS) $(INCLUDES) $(DEFINES) $< -o $@
 
 $(BUILD_DIRS):
 	$(MKDIR) $@
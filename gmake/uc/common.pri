@@ -8,3 +8,4 @@ LKELF = $(CROSS_COMPILE)g++
 OBJCOPY = $(CROSS_COMPILE)objcopy
 RM=rm -Rf
 MKDIR=mkdir -p
+HOST_CXX=g++
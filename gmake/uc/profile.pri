@@ -0,0 +1,22 @@
+# Microcontroller build profiles, set these in project.conf or on the command line.
+#   make TP_UC_PROFILE=size TP_UC_LTO=1
+#
+# TP_UC_PROFILE - size (-Os), each function and variable is put in its own section so that the
+#                 linker can drop the ones that are not used. Empty uses the toolchain flags.
+# TP_UC_LTO     - Link time optimization, the toolchain must have been built with LTO support. The
+#                 size report can't attribute LTO code to modules, it is listed as [lto].
+#
+# The flash and RAM used by each module are checked against TP_FLASH_BUDGETS and TP_RAM_BUDGETS
+# after every link, see common/size.pri.
+
+ifeq ($(TP_UC_PROFILE), size)
+CFLAGS += -Os -ffunction-sections -fdata-sections
+LDFLAGS += -Os -Wl,--gc-sections
+endif
+
+# LTO objects hold GIMPLE rather than code, gcc-ar adds the symbol index that the linker needs.
+ifdef TP_UC_LTO
+CFLAGS += -flto
+LDFLAGS += -flto
+AR = $(CROSS_COMPILE)gcc-ar
+endif
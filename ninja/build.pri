@@ -0,0 +1,234 @@
+# Writes a build.ninja for the whole project from the same submodules.pri, vars.pri and
+# dependencies.pri files that the other builds use. Run this from the top level directory:
+#   make -f tp_build/ninja/build.pri
+#   ninja -C build
+#
+# The build.ninja regenerates itself when any of the .pri files change.
+
+ROOT = $(CURDIR)/
+
+-include $(ROOT)toolchain.pri
+
+include $(ROOT)tp_build/gmake/static/common.pri
+
+# Bring in project wide config
+include $(ROOT)project.inc
+include $(ROOT)$(PROJECT_DIR)/project.conf
+
+include $(ROOT)$(PROJECT_DIR)/submodules.pri
+$(foreach p,$(SUBPROJECTS),$(eval include $(ROOT)$(p)/submodules.pri))
+
+# Modules shared by several SUBPROJECTS are built once, keeping the order of their first use as
+# gmake/build.pri does.
+tp_unique = $(if $(1),$(firstword $(1)) $(call tp_unique,$(filter-out $(firstword $(1)),$(1))))
+SUBDIRS := $(call tp_unique,$(patsubst %/,%,$(SUBDIRS)))
+
+include $(ROOT)tp_build/gmake/common/sanitize.pri
+include $(ROOT)tp_build/gmake/common/build_times.pri
+include $(ROOT)tp_build/gmake/common/modules.pri
+
+NINJA_DIR = $(ROOT)$(BUILD_DIR)
+NINJA_FILE = $(NINJA_DIR)build.ninja
+
+TP_TEST_JOBS ?= 0
+TP_TEST_TIMEOUT ?= 0
+
+TP_TEST_ARGS = -j$(TP_TEST_JOBS) --timeout=$(TP_TEST_TIMEOUT)
+ifdef TP_PERF_COUNTERS
+TP_TEST_ARGS += --perf-counters
+TP_BENCH_ARGS += --perf-counters
+endif
+ifdef TP_BENCH_PIN_CPU
+TP_BENCH_ARGS += --pin-cpu=$(TP_BENCH_PIN_CPU)
+endif
+
+tp_ninja = $(file >>$(NINJA_FILE),$(1))
+
+# Paths in build.ninja are relative to the build directory, sources are absolute.
+tp_ninja_obj_dir = $($(1)_TARGET)/
+
+# With TP_TELEMETRY=1 every compile, archive, link and tool runs through tpTelemetry, see
+# gmake/common/telemetry.pri.
+TP_NINJA_TELEMETRY = $(if $(TP_TELEMETRY), || tpTelemetry)
+
+TP_NINJA_REPLACE_CHANGED = { cmp -s $$out.tmp $$out && rm -f $$out.tmp || mv -f $$out.tmp $$out; }
+
+define TP_NINJA_HEADER
+# Generated by tp_build/ninja/build.pri, changes will be overwritten.
+ninja_required_version = 1.5
+
+root = $(ROOT)
+cc = $(CC)
+cxx = $(CXX)
+ar = $(AR)
+host_cxx = $(HOST_CXX)
+telemetry = $(if $(TP_TELEMETRY),./tpTelemetry run --log=telemetry.log --)
+
+rule cc
+  command = $$telemetry $$cc -MMD -MF $$out.d $$flags -c $$in -o $$out
+  depfile = $$out.d
+  deps = gcc
+  description = CC $$out
+
+rule cxx
+  command = $$telemetry $$cxx -MMD -MF $$out.d $$flags -c $$in -o $$out
+  depfile = $$out.d
+  deps = gcc
+  description = CXX $$out
+
+rule ar
+  command = rm -f $$out && $$telemetry $$ar rcs $$out $$in
+  description = AR $$out
+
+rule link
+  command = $$telemetry $$cxx $$in $$libs $$flags -o $$out
+  description = LINK $$out
+
+rule host_cxx
+  command = $$host_cxx -std=gnu++1z -O2 $$in -o $$out
+  description = HOST_CXX $$out
+
+# Generated sources are written to a temporary file and only replace the output when they change,
+# restat then skips compiling them again.
+rule tp_rc
+  command = $$telemetry ./tpRc $$in $$out.tmp $$name > /dev/null && (printf '%s: ' $$out; tr '\n' ' ' < $$out.tmp.dep) > $$out.d && rm -f $$out.tmp.dep && $(TP_NINJA_REPLACE_CHANGED)
+  depfile = $$out.d
+  deps = gcc
+  restat = 1
+  description = TP_RC $$out
+
+rule static_init
+  command = $$telemetry bash $${root}tp_build/tp_static_init/generate_static_init.sh $$out.tmp $$name && $(TP_NINJA_REPLACE_CHANGED)
+  restat = 1
+  description = STATIC_INIT $$out
+
+rule copy
+  command = ./tpCopy $(if $(TP_COPY_HARDLINK),--hardlink )$$in $$out
+  description = COPY $$out
+
+rule run
+  command = $$command
+  pool = console
+
+# Variables given on the command line when build.ninja was generated are passed on each time it
+# regenerates itself. toolchain.pri is optional, while it is missing the top level directory is an
+# input so that creating it changes the time of the directory and regenerates build.ninja. A phony
+# build for the missing file would make build.ninja dirty on every run.
+rule configure
+  command = $(MAKE) -s -C $$root -f tp_build/ninja/build.pri $(subst $$,$$$$,$(MAKEOVERRIDES))
+  generator = 1
+  description = Regenerating build.ninja
+
+build build.ninja: configure | $(sort $(abspath $(MAKEFILE_LIST)))$(if $(wildcard $(ROOT)toolchain.pri),, $(patsubst %/,%,$(ROOT)))
+
+build tpRc: host_cxx $${root}tp_build/tp_rc/tp_rc.cpp
+build tpTest: host_cxx $${root}tp_build/tp_test/tp_test.cpp
+build tpBenchCheck: host_cxx $${root}tp_build/tp_bench/tp_bench_check.cpp
+build tpCopy: host_cxx $${root}tp_build/tp_copy/tp_copy.cpp
+build tpCriticalPath: host_cxx $${root}tp_build/tp_critical_path/tp_critical_path.cpp
+build tpTelemetry: host_cxx $${root}tp_build/tp_telemetry/tp_telemetry.cpp
+build tp_always: phony
+
+endef
+
+define TP_NINJA_COMPILE
+build $(call tp_ninja_obj_dir,$(1))$(2).o: $(if $(filter %.c,$(2)),cc,cxx) $(3)$(TP_NINJA_TELEMETRY)
+  flags = $($(1)_CFLAGS) $(if $(filter %.c,$(2)),$($(1)_CCFLAGS),$($(1)_CXXFLAGS)) $(call tp_module_includes,$(1)) $(call tp_module_defines,$(1))
+endef
+
+define TP_NINJA_RC
+build $(call tp_ninja_obj_dir,$(1))$(2).cpp: tp_rc $(call tp_module_dir,$(1))$(2) | tpRc$(TP_NINJA_TELEMETRY)
+  name = $(basename $(notdir $(2)))
+endef
+
+define TP_NINJA_STATIC_INIT
+build $(call tp_ninja_obj_dir,$(1))static_init/$(2).cpp: static_init | $(ROOT)$(2)/inc/$(2)/Globals.h $(ROOT)$(2)/src/Globals.cpp $(ROOT)tp_build/tp_static_init/generate_static_init.sh$(TP_NINJA_TELEMETRY)
+  name = $(2)
+endef
+
+define TP_NINJA_ARCHIVE
+build $($(1)_OUTPUT): ar $($(1)_OBJECTS)$(TP_NINJA_TELEMETRY)
+endef
+
+define TP_NINJA_LINK
+build $($(1)_OUTPUT): link $($(1)_OBJECTS) | $(addsuffix .a,$(filter $(TP_LIB_TARGETS),$($(1)_LIBRARIES)))$(TP_NINJA_TELEMETRY)
+  libs = $($(1)_LINK_LIBS)
+  flags = $($(1)_LFLAGS)
+endef
+
+# Ninja can't see changes inside a directory so these always run tpCopy, which only copies the
+# files that changed.
+define TP_NINJA_COPY
+build $(2): copy $(call tp_module_dir,$(1))$(2) | tpCopy$(if $(wildcard $(call tp_module_dir,$(1))$(2)/.), tp_always)
+endef
+
+# Generated sources (resources and static init) are compiled like any other source.
+define TP_NINJA_MODULE
+$(1)_RC_SOURCES := $(addsuffix .cpp,$(addprefix $(call tp_ninja_obj_dir,$(1)),$(filter %.qrc,$($(1)_TP_RC))))
+$(1)_INIT_SOURCES := $(if $(filter app test bench,$($(1)_TEMPLATE)),$(foreach f,$(call uniq,$($(1)_TP_STATIC_INIT)),$(call tp_ninja_obj_dir,$(1))static_init/$(f).cpp))
+$(1)_OBJECTS := $(addprefix $(call tp_ninja_obj_dir,$(1)),$(addsuffix .o,$(filter %.c %.cpp,$($(1)_SOURCES))))
+$(1)_OBJECTS += $$(addsuffix .o,$$($(1)_RC_SOURCES) $$($(1)_INIT_SOURCES))
+$(1)_OUTPUT := $(if $(filter lib,$($(1)_TEMPLATE)),$($(1)_TARGET).a,$(if $(filter app test bench,$($(1)_TEMPLATE)),$(call tp_ninja_obj_dir,$(1))$($(1)_TARGET)))
+
+$(1)_LINK_LIBS := $(patsubst -l-l%,-l%,$(patsubst -l-L%,-L%,$(addprefix -l,$($(1)_LIBS))))
+$(1)_LINK_LIBS += $(patsubst -L$(ROOT)/%,-L/%,$(addprefix -L$(ROOT),$($(1)_LIBRARYPATHS)))
+$(1)_LINK_LIBS := $(foreach LIB,$($(1)_LIBRARIES),$(if $(filter $(LIB),$(TP_LIB_TARGETS)),$(LIB).a,$(NINJA_DIR)$(LIB).a)) $$($(1)_LINK_LIBS)
+endef
+
+define TP_NINJA_WRITE_MODULE
+$(foreach s,$(filter %.c %.cpp,$($(1)_SOURCES)),$(call tp_ninja,$(call TP_NINJA_COMPILE,$(1),$(s),$(call tp_module_dir,$(1))$(s))))
+$(foreach s,$($(1)_RC_SOURCES) $($(1)_INIT_SOURCES),$(call tp_ninja,$(call TP_NINJA_COMPILE,$(1),$(patsubst $(call tp_ninja_obj_dir,$(1))%,%,$(s)),$(s))))
+$(foreach r,$(filter %.qrc,$($(1)_TP_RC)),$(call tp_ninja,$(call TP_NINJA_RC,$(1),$(r))))
+$(foreach f,$(call uniq,$($(1)_TP_STATIC_INIT)),$(if $($(1)_INIT_SOURCES),$(call tp_ninja,$(call TP_NINJA_STATIC_INIT,$(1),$(f)))))
+$(if $(filter lib,$($(1)_TEMPLATE)),$(call tp_ninja,$(call TP_NINJA_ARCHIVE,$(1))))
+$(if $(filter app test bench,$($(1)_TEMPLATE)),$(call tp_ninja,$(call TP_NINJA_LINK,$(1))))
+$(foreach f,$($(1)_TP_COPY),$(call tp_ninja,$(call TP_NINJA_COPY,$(1),$(f))))
+$(call tp_ninja,build $(1): phony $($(1)_OUTPUT) $($(1)_TP_COPY))
+$(call tp_ninja,$(TP_NINJA_NL))
+endef
+
+define TP_NINJA_NL
+
+
+endef
+
+TP_TEST_TARGETS = $(foreach m,$(SUBDIRS),$(if $(filter test,$($(m)_TEMPLATE)),$(m)))
+TP_BENCH_TARGETS = $(foreach m,$(SUBDIRS),$(if $(filter bench,$($(m)_TEMPLATE)),$(m)))
+
+define TP_NINJA_FOOTER
+build tests: run | tpTest $(TP_TEST_TARGETS)
+  command = ./run_tests.sh $(TP_TEST_ARGS)
+  description = Running tests
+
+build benchmarks: run | $(TP_BENCH_TARGETS)
+  command = ./run_benchmarks.sh $(TP_BENCH_ARGS)
+  description = Running benchmarks
+
+build critical-path: run | tpCriticalPath
+  command = ./tpCriticalPath --trace=critical_path.json $(TP_CRITICAL_PATH_MODULES) .ninja_log
+  description = Finding the critical path of the build
+
+build telemetry-report: run | tpTelemetry
+  command = ./tpTelemetry report --top=$(or $(TP_TELEMETRY_TOP),10) --trace=telemetry.json telemetry.log
+  description = Summarizing the build telemetry
+
+build all: phony $(SUBDIRS)
+default all
+endef
+
+$(shell mkdir -p $(NINJA_DIR))
+$(file >$(NINJA_FILE),$(TP_NINJA_HEADER))
+$(foreach m,$(SUBDIRS),$(eval $(call TP_NINJA_MODULE,$(m))))
+$(foreach m,$(SUBDIRS),$(eval $(call TP_NINJA_WRITE_MODULE,$(m))))
+$(call tp_ninja,$(TP_NINJA_FOOTER))
+
+tp_ninja_lines = $(subst $(TP_NINJA_SPACE),$(TP_NINJA_NL),$(strip $(1)))
+TP_NINJA_EMPTY :=
+TP_NINJA_SPACE := $(TP_NINJA_EMPTY) $(TP_NINJA_EMPTY)
+
+$(file >$(NINJA_DIR)tests.txt,$(call tp_ninja_lines,$(foreach m,$(TP_TEST_TARGETS),./$($(m)_TARGET)/$($(m)_TARGET))))
+$(file >$(NINJA_DIR)benchmarks.txt,$(call tp_ninja_lines,$(foreach m,$(TP_BENCH_TARGETS),./$($(m)_TARGET)/$($(m)_TARGET))))
+$(shell cp $(ROOT)tp_build/tp_test/run_tests.sh $(ROOT)tp_build/tp_bench/run_benchmarks.sh $(NINJA_DIR))
+
+all:
+	@echo "Generated: $(NINJA_FILE)"
@@ -6,9 +6,9 @@ SOURCES_DIR=$1
 TEMPLATE=$2
 ROOT_URL=$3
 
-export WINDOW_TITLE="Thomas Paynter CV"
-export ROOT_URL
-
+# Each file is passed to tpMustache which makes it available to the template as a variable named
+# after the file, see tp_mustache.cpp.
+FILES=()
 for var in "${@:4}"
 do
   filename=$(basename -- "$var")
@@ -16,19 +16,15 @@ do
   filename="${filename%.*}"
 
   if [ $extension = "html" ]; then
-    tmp=`cat "$var"`
-    eval $filename=\$tmp
-    export $filename
+    FILES+=("$var")
   fi
 
   if [ $extension = "md" ]; then
-    tmp=`pandoc "$var"`
-    eval $filename=\$tmp
-    export $filename
+    mkdir -p fragments
+    pandoc "$var" -o "fragments/${filename}.html"
+    FILES+=("fragments/${filename}.html")
   fi
 
 done
 
-mo ${TEMPLATE} -u > result1.html
-mo result1.html -u > result2.html
-mv result2.html result.html
+"${TP_MUSTACHE:-tpMustache}" -u --env --var="WINDOW_TITLE=Thomas Paynter CV" --var="ROOT_URL=${ROOT_URL}" "${TEMPLATE}" result.html "${FILES[@]}"
@@ -0,0 +1,33 @@
+#!/bin/bash
+
+# Converts a markdown file into an html fragment using pandoc, the results are cached by a hash of the
+# input and the pandoc version so that a file is only converted once even after a clean build.
+#   pandoc_cached.sh <cache directory> <input.md> <output.html>
+#
+# The output is only written if it changes so that pages that use it are not rebuilt.
+
+set -e
+
+CACHE_DIR=$1
+INPUT=$2
+OUTPUT=$3
+
+if which sha256sum > /dev/null 2>&1; then
+  HASH_CMD="sha256sum"
+else
+  HASH_CMD="shasum -a 256"
+fi
+
+KEY=$( (pandoc --version | head -n 1; cat "${INPUT}") | ${HASH_CMD} | cut -c1-40)
+CACHED="${CACHE_DIR}/${KEY}.html"
+
+if [ ! -f "${CACHED}" ]; then
+  mkdir -p "${CACHE_DIR}"
+  pandoc "${INPUT}" -o "${CACHED}.$$"
+  mv "${CACHED}.$$" "${CACHED}"
+fi
+
+mkdir -p "$(dirname "${OUTPUT}")"
+if ! cmp -s "${CACHED}" "${OUTPUT}"; then
+  cp "${CACHED}" "${OUTPUT}"
+fi
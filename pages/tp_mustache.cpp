@@ -0,0 +1,355 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <stdexcept>
+#include <filesystem>
+#include <cstdlib>
+
+namespace
+{
+
+//##################################################################################################
+struct Params_lt
+{
+  std::string templatePath;
+  std::string outputPath;
+  std::map<std::string, std::string> variables;
+  bool environment{false};
+  bool failOnUnset{false};
+};
+
+//##################################################################################################
+bool readTextFile(const std::string& fileName, std::string& results)
+{
+  std::ifstream in(fileName, std::ios::binary);
+  if(!in)
+    return false;
+
+  std::stringstream ss;
+  ss << in.rdbuf();
+  results = ss.str();
+  return true;
+}
+
+//##################################################################################################
+std::string trim(const std::string& text)
+{
+  auto start = text.find_first_not_of(" \t");
+  if(start == std::string::npos)
+    return std::string();
+  auto end = text.find_last_not_of(" \t");
+  return text.substr(start, end-start+1);
+}
+
+//##################################################################################################
+//! Renders mustache templates the way the pages used mo, values are not HTML escaped and the tags in
+//! a value are expanded as well, which is what the second mo pass used to do.
+class Renderer_lt
+{
+public:
+  //################################################################################################
+  Renderer_lt(const Params_lt& params, std::ostream& out):
+    m_params(params),
+    m_out(out)
+  {
+
+  }
+
+  //################################################################################################
+  void render(const std::string& text, const std::filesystem::path& directory, int depth)
+  {
+    // Values and partials can contain tags, this stops a value that includes itself.
+    if(depth>16)
+      throw std::runtime_error("Templates nested too deeply, does a variable include itself?");
+
+    std::string open = "{{";
+    std::string close = "}}";
+
+    size_t pos=0;
+    while(pos<text.size())
+    {
+      Tag_lt tag;
+      if(!findTag(text, pos, open, close, tag))
+      {
+        m_out.write(text.data()+pos, std::streamsize(text.size()-pos));
+        return;
+      }
+
+      m_out.write(text.data()+pos, std::streamsize(tag.writeEnd-pos));
+      pos = tag.resumeAt;
+
+      switch(tag.type)
+      {
+      case '!':
+        break;
+
+      case '=':
+      {
+        std::stringstream ss(tag.name.substr(0, tag.name.size()-(tag.name.back()=='='?1:0)));
+        if(!(ss >> open >> close))
+          throw std::runtime_error("Invalid set delimiter tag: " + tag.name);
+        break;
+      }
+
+      case '>':
+      {
+        std::string partial;
+        auto path = directory / tag.name;
+        if(!readTextFile(path.string(), partial))
+          throw std::runtime_error("Failed to read partial: " + path.string());
+        render(partial, path.parent_path(), depth+1);
+        break;
+      }
+
+      case '#':
+      case '^':
+      {
+        size_t contentEnd=0;
+        size_t sectionEnd=0;
+        findSectionEnd(text, pos, open, close, tag.name, contentEnd, sectionEnd);
+
+        const std::string* value = lookup(tag.name, false);
+        bool truthy = value && !value->empty();
+        if(truthy == (tag.type=='#'))
+          render(text.substr(pos, contentEnd-pos), directory, depth);
+        pos = sectionEnd;
+        break;
+      }
+
+      case '/':
+        throw std::runtime_error("Unexpected section close: " + tag.name);
+
+      default:
+      {
+        if(const std::string* value = lookup(tag.name, m_params.failOnUnset); value)
+          render(*value, directory, depth+1);
+        break;
+      }
+      }
+    }
+  }
+
+private:
+  //################################################################################################
+  struct Tag_lt
+  {
+    char type{0};        //!< One of # ^ / ! > = or 0 for a variable.
+    std::string name;
+    size_t writeEnd{0};  //!< Text before the tag that should be written.
+    size_t resumeAt{0};  //!< Position after the tag, including the line of a standalone tag.
+  };
+
+  //################################################################################################
+  bool findTag(const std::string& text, size_t pos, const std::string& open, const std::string& close, Tag_lt& tag) const
+  {
+    auto start = text.find(open, pos);
+    if(start == std::string::npos)
+      return false;
+
+    size_t inner = start+open.size();
+    std::string end = close;
+    if(open == "{{" && inner<text.size() && text.at(inner) == '{')
+    {
+      inner++;
+      end = "}" + close;
+    }
+
+    auto finish = text.find(end, inner);
+    if(finish == std::string::npos)
+      throw std::runtime_error("Unclosed tag: " + text.substr(start, 40));
+
+    std::string content = trim(text.substr(inner, finish-inner));
+    tag = Tag_lt();
+    if(!content.empty() && std::string("#^/!>=&").find(content.front()) != std::string::npos)
+    {
+      tag.type = (content.front()=='&')?0:content.front();
+      content = trim(content.substr(1));
+    }
+    tag.name = content;
+    tag.writeEnd = start;
+    tag.resumeAt = finish+end.size();
+
+    // A section, comment, partial or delimiter tag on a line of its own removes the whole line.
+    if(tag.type != 0)
+    {
+      auto lineStart = text.find_last_of('\n', (start>0)?start-1:0);
+      lineStart = (lineStart == std::string::npos || start==0)?0:lineStart+1;
+      if(start>0 && text.at(start-1) == '\n')
+        lineStart = start;
+
+      auto lineEnd = text.find('\n', tag.resumeAt);
+      bool before = text.find_first_not_of(" \t", lineStart) >= start;
+      size_t afterEnd = (lineEnd == std::string::npos)?text.size():lineEnd;
+      bool after = text.find_first_not_of(" \t\r", tag.resumeAt) >= afterEnd;
+
+      if(before && after && lineStart>=pos)
+      {
+        tag.writeEnd = lineStart;
+        tag.resumeAt = (lineEnd == std::string::npos)?text.size():lineEnd+1;
+      }
+    }
+
+    return true;
+  }
+
+  //################################################################################################
+  void findSectionEnd(const std::string& text, size_t pos, const std::string& open, const std::string& close, const std::string& name, size_t& contentEnd, size_t& sectionEnd) const
+  {
+    int level=1;
+    Tag_lt tag;
+    while(findTag(text, pos, open, close, tag))
+    {
+      if((tag.type=='#' || tag.type=='^') && tag.name == name)
+        level++;
+      else if(tag.type=='/' && tag.name == name && --level == 0)
+      {
+        contentEnd = tag.writeEnd;
+        sectionEnd = tag.resumeAt;
+        return;
+      }
+      pos = tag.resumeAt;
+    }
+
+    throw std::runtime_error("Section not closed: " + name);
+  }
+
+  //################################################################################################
+  const std::string* lookup(const std::string& name, bool required)
+  {
+    if(auto i = m_params.variables.find(name); i != m_params.variables.end())
+      return &i->second;
+
+    if(m_params.environment)
+    {
+      if(auto i = m_environment.find(name); i != m_environment.end())
+        return &i->second;
+
+      if(const char* value = std::getenv(name.c_str()); value)
+        return &(m_environment[name] = value);
+    }
+
+    if(required)
+      throw std::runtime_error("Variable not set: " + name);
+
+    return nullptr;
+  }
+
+  const Params_lt& m_params;
+  std::ostream& m_out;
+  std::map<std::string, std::string> m_environment;
+};
+
+//##################################################################################################
+void printUsage()
+{
+  std::cerr << "Usage: tpMustache [options] <template> <output> [files...]\n"
+               "  Renders a mustache template, each file is available as a variable named after the\n"
+               "  file without its extension.\n"
+               "  --var=NAME=VALUE  Set a variable.\n"
+               "  --env             Use environment variables for names that are not otherwise set.\n"
+               "  -u                Fail if a variable is not set.\n";
+}
+
+//##################################################################################################
+bool parseArgs(int argc, const char* argv[], Params_lt& params)
+{
+  std::vector<std::string> positional;
+  for(int i=1; i<argc; i++)
+  {
+    std::string arg = argv[i];
+    if(arg.compare(0, 6, "--var=") == 0)
+    {
+      auto equals = arg.find('=', 6);
+      if(equals == std::string::npos)
+        return false;
+      params.variables[arg.substr(6, equals-6)] = arg.substr(equals+1);
+    }
+    else if(arg == "--env")
+      params.environment = true;
+    else if(arg == "-u")
+      params.failOnUnset = true;
+    else if(arg.compare(0, 1, "-") == 0)
+      return false;
+    else
+      positional.push_back(arg);
+  }
+
+  if(positional.size()<2)
+    return false;
+
+  params.templatePath = positional.at(0);
+  params.outputPath = positional.at(1);
+
+  for(size_t i=2; i<positional.size(); i++)
+  {
+    std::string content;
+    if(!readTextFile(positional.at(i), content))
+    {
+      std::cerr << "error: Failed to read: " << positional.at(i) << std::endl;
+      return false;
+    }
+
+    // Trailing new lines are dropped the same way that $(cat file) did for mo.
+    while(!content.empty() && content.back() == '\n')
+      content.pop_back();
+
+    params.variables[std::filesystem::path(positional.at(i)).stem().string()] = std::move(content);
+  }
+
+  return true;
+}
+}
+
+//##################################################################################################
+int main(int argc, const char* argv[])
+{
+  Params_lt params;
+  if(!parseArgs(argc, argv, params))
+  {
+    printUsage();
+    return 1;
+  }
+
+  std::string text;
+  if(!readTextFile(params.templatePath, text))
+  {
+    std::cerr << "error: Failed to read template: " << params.templatePath << std::endl;
+    return 1;
+  }
+
+  // Written next to the output and renamed so that a failed render doesn't leave a partial page.
+  std::string tmpPath = params.outputPath + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios::binary);
+    if(!out)
+    {
+      std::cerr << "error: Failed to write: " << tmpPath << std::endl;
+      return 1;
+    }
+
+    try
+    {
+      Renderer_lt(params, out).render(text, std::filesystem::path(params.templatePath).parent_path(), 0);
+    }
+    catch(const std::exception& e)
+    {
+      std::cerr << "error: " << params.templatePath << ": " << e.what() << std::endl;
+      out.close();
+      std::filesystem::remove(tmpPath);
+      return 1;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmpPath, params.outputPath, ec);
+  if(ec)
+  {
+    std::cerr << "error: Failed to write: " << params.outputPath << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,901 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <filesystem>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+
+namespace
+{
+
+//##################################################################################################
+struct Params_lt
+{
+  std::string inputPath;
+  std::string outputPath;
+  std::string sourceDir{"."};
+  std::string assetDir{"assets"};
+  std::string listPath;
+  size_t inlineLimit{2048};
+};
+
+//##################################################################################################
+bool readTextFile(const std::string& fileName, std::string& results)
+{
+  std::ifstream in(fileName, std::ios::binary);
+  if(!in)
+    return false;
+
+  std::stringstream ss;
+  ss << in.rdbuf();
+  results = ss.str();
+  return true;
+}
+
+//##################################################################################################
+bool writeTextFile(const std::string& fileName, const std::string& text)
+{
+  std::ofstream out(fileName, std::ios::binary);
+  if(!out)
+    return false;
+  out << text;
+  return bool(out);
+}
+
+//##################################################################################################
+std::string toLower(std::string text)
+{
+  std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c){return char(std::tolower(c));});
+  return text;
+}
+
+//##################################################################################################
+bool startsWith(const std::string& text, size_t pos, const char* prefix, bool caseInsensitive=false)
+{
+  for(size_t i=0; prefix[i]; i++, pos++)
+  {
+    if(pos>=text.size())
+      return false;
+    char a = text.at(pos);
+    char b = prefix[i];
+    if(caseInsensitive ? (std::tolower(a) != std::tolower(b)) : (a != b))
+      return false;
+  }
+  return true;
+}
+
+//##################################################################################################
+size_t findCaseInsensitive(const std::string& text, const std::string& needle, size_t pos)
+{
+  auto i = std::search(text.begin()+long(pos), text.end(), needle.begin(), needle.end(), [](char a, char b)
+  {
+    return std::tolower(a) == std::tolower(b);
+  });
+  return (i==text.end())?std::string::npos:size_t(i-text.begin());
+}
+
+//##################################################################################################
+// Hashes are only used to give assets unique names, they don't need to be cryptographic.
+std::string contentHash(const std::string& text)
+{
+  uint64_t hash=14695981039346656037ull;
+  for(char c : text)
+    hash = (hash ^ uint8_t(c)) * 1099511628211ull;
+
+  char buffer[17];
+  snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+  return buffer;
+}
+
+//##################################################################################################
+std::string base64(const std::string& data)
+{
+  static const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string result;
+  result.reserve(((data.size()+2)/3)*4);
+  for(size_t i=0; i<data.size(); i+=3)
+  {
+    uint32_t n = uint32_t(uint8_t(data[i]))<<16;
+    if(i+1<data.size()) n |= uint32_t(uint8_t(data[i+1]))<<8;
+    if(i+2<data.size()) n |= uint32_t(uint8_t(data[i+2]));
+    result += chars[(n>>18)&63];
+    result += chars[(n>>12)&63];
+    result += (i+1<data.size())?chars[(n>>6)&63]:'=';
+    result += (i+2<data.size())?chars[n&63]:'=';
+  }
+  return result;
+}
+
+//##################################################################################################
+//! Types that can be inlined as a data: URI, other files are always given a hashed name.
+std::string mimeType(const std::string& extension)
+{
+  static const std::map<std::string, std::string> types =
+  {
+    {".png",   "image/png"},
+    {".jpg",   "image/jpeg"},
+    {".jpeg",  "image/jpeg"},
+    {".gif",   "image/gif"},
+    {".webp",  "image/webp"},
+    {".svg",   "image/svg+xml"},
+    {".ico",   "image/x-icon"},
+    {".woff",  "font/woff"},
+    {".woff2", "font/woff2"}
+  };
+
+  auto i = types.find(toLower(extension));
+  return (i==types.end())?std::string():i->second;
+}
+
+//##################################################################################################
+bool isSpace(char c)
+{
+  return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\f';
+}
+
+//##################################################################################################
+bool isIdentifier(char c)
+{
+  return std::isalnum(static_cast<unsigned char>(c)) || c=='_' || c=='$' || c=='\\' || static_cast<unsigned char>(c)>126;
+}
+
+//##################################################################################################
+//! Copies a quoted string starting at pos, returns the position after the closing quote.
+size_t copyString(const std::string& text, size_t pos, std::string& out)
+{
+  char quote = text.at(pos);
+  size_t i=pos+1;
+  for(; i<text.size() && text.at(i)!=quote; i++)
+    if(text.at(i)=='\\')
+      i++;
+  i = std::min(i+1, text.size());
+  out.append(text, pos, i-pos);
+  return i;
+}
+
+//##################################################################################################
+//! Removes comments and the whitespace that doesn't change the meaning of the style sheet.
+std::string minifyCss(const std::string& css)
+{
+  // Space before a ':' is kept because "a :hover" and "a:hover" are different selectors.
+  auto tightBefore = [](char c){return c=='{' || c=='}' || c==';' || c==',' || c=='>';};
+  auto tightAfter  = [](char c){return c=='{' || c=='}' || c==';' || c==',' || c=='>' || c==':';};
+
+  std::string out;
+  out.reserve(css.size());
+  bool space=false;
+  for(size_t i=0; i<css.size();)
+  {
+    char c = css.at(i);
+    if(c=='/' && startsWith(css, i, "/*"))
+    {
+      auto end = css.find("*/", i+2);
+      i = (end==std::string::npos)?css.size():end+2;
+      space = true;
+      continue;
+    }
+
+    if(isSpace(c))
+    {
+      space = true;
+      i++;
+      continue;
+    }
+
+    if(space && !out.empty() && !tightAfter(out.back()) && !tightBefore(c))
+      out += ' ';
+    space = false;
+
+    if(c=='}' && !out.empty() && out.back()==';')
+      out.pop_back();
+
+    if(c=='"' || c=='\'')
+      i = copyString(css, i, out);
+    else
+    {
+      out += c;
+      i++;
+    }
+  }
+  return out;
+}
+
+//##################################################################################################
+//! A conservative minifier in the style of JSMin, comments are removed and runs of whitespace are
+//! reduced to a single space or new line. New lines are kept so that automatic semicolon insertion
+//! is not affected.
+std::string minifyJs(const std::string& js)
+{
+  auto regexCanFollow = [](const std::string& out)
+  {
+    size_t i = out.find_last_not_of(" \n");
+    if(i==std::string::npos)
+      return true;
+    if(std::string("(,=:[!&|?{};~+-*%<>^\n").find(out.at(i)) != std::string::npos)
+      return true;
+    for(const char* keyword : {"return", "typeof", "case", "do", "else", "in", "of"})
+    {
+      size_t n = strlen(keyword);
+      if(i+1>=n && out.compare(i+1-n, n, keyword)==0 && (i+1==n || !isIdentifier(out.at(i-n))))
+        return true;
+    }
+    return false;
+  };
+
+  std::string out;
+  out.reserve(js.size());
+  bool space=false;
+  bool newLine=false;
+  for(size_t i=0; i<js.size();)
+  {
+    char c = js.at(i);
+    if(c=='/' && startsWith(js, i, "//"))
+    {
+      i = js.find('\n', i);
+      if(i==std::string::npos)
+        break;
+      continue;
+    }
+
+    if(c=='/' && startsWith(js, i, "/*"))
+    {
+      auto end = js.find("*/", i+2);
+      if(js.find('\n', i) < end)
+        newLine = true;
+      i = (end==std::string::npos)?js.size():end+2;
+      space = true;
+      continue;
+    }
+
+    if(isSpace(c))
+    {
+      space = true;
+      newLine = newLine || c=='\n';
+      i++;
+      continue;
+    }
+
+    if(space && !out.empty())
+    {
+      char p = out.back();
+      if(newLine)
+        out += '\n';
+      else if((isIdentifier(p) && isIdentifier(c)) || (p=='+' && c=='+') || (p=='-' && c=='-') || (p=='/' && c=='/'))
+        out += ' ';
+    }
+    space = false;
+    newLine = false;
+
+    if(c=='"' || c=='\'' || c=='`')
+    {
+      i = copyString(js, i, out);
+      continue;
+    }
+
+    if(c=='/' && regexCanFollow(out))
+    {
+      size_t j=i+1;
+      bool inClass=false;
+      for(; j<js.size() && js.at(j)!='\n'; j++)
+      {
+        char r = js.at(j);
+        if(r=='\\')
+          j++;
+        else if(r=='[')
+          inClass = true;
+        else if(r==']')
+          inClass = false;
+        else if(r=='/' && !inClass)
+          break;
+      }
+      j = std::min(j+1, js.size());
+      out.append(js, i, j-i);
+      i = j;
+      continue;
+    }
+
+    out += c;
+    i++;
+  }
+
+  while(!out.empty() && isSpace(out.back()))
+    out.pop_back();
+  return out;
+}
+
+//##################################################################################################
+struct Attribute_lt
+{
+  std::string name;  //!< Lower case.
+  std::string value;
+  std::string raw;   //!< The original text including the leading whitespace.
+  bool modified{false};
+  bool remove{false};
+};
+
+//##################################################################################################
+struct Tag_lt
+{
+  std::string name;  //!< Lower case.
+  std::vector<Attribute_lt> attributes;
+  std::string tail;  //!< Whitespace and / before the >.
+
+  //################################################################################################
+  Attribute_lt* find(const std::string& attributeName)
+  {
+    for(auto& a : attributes)
+      if(a.name == attributeName && !a.remove)
+        return &a;
+    return nullptr;
+  }
+
+  //################################################################################################
+  std::string toString() const
+  {
+    std::string result = "<" + name;
+    for(const auto& a : attributes)
+    {
+      if(a.remove)
+        continue;
+      if(a.modified)
+        result += " " + a.name + "=\"" + a.value + "\"";
+      else
+        result += a.raw;
+    }
+    return result + tail + ">";
+  }
+};
+
+//##################################################################################################
+//! Parses the tag at pos, returns the position after the > or npos if it is not a tag.
+size_t parseTag(const std::string& html, size_t pos, Tag_lt& tag)
+{
+  size_t i=pos+1;
+  while(i<html.size() && (std::isalnum(static_cast<unsigned char>(html.at(i))) || html.at(i)=='-'))
+    i++;
+  if(i==pos+1)
+    return std::string::npos;
+
+  tag = Tag_lt();
+  tag.name = toLower(html.substr(pos+1, i-pos-1));
+
+  while(i<html.size())
+  {
+    size_t start=i;
+    while(i<html.size() && (isSpace(html.at(i)) || html.at(i)=='/'))
+      i++;
+
+    if(i>=html.size())
+      return std::string::npos;
+
+    if(html.at(i)=='>')
+    {
+      tag.tail = html.substr(start, i-start);
+      return i+1;
+    }
+
+    Attribute_lt a;
+    size_t nameStart=i;
+    while(i<html.size() && !isSpace(html.at(i)) && html.at(i)!='=' && html.at(i)!='>' && html.at(i)!='/')
+      i++;
+    a.name = toLower(html.substr(nameStart, i-nameStart));
+
+    size_t j=i;
+    while(j<html.size() && isSpace(html.at(j)))
+      j++;
+    if(j<html.size() && html.at(j)=='=')
+    {
+      j++;
+      while(j<html.size() && isSpace(html.at(j)))
+        j++;
+      if(j<html.size() && (html.at(j)=='"' || html.at(j)=='\''))
+      {
+        auto end = html.find(html.at(j), j+1);
+        if(end==std::string::npos)
+          return std::string::npos;
+        a.value = html.substr(j+1, end-j-1);
+        i = end+1;
+      }
+      else
+      {
+        size_t valueStart=j;
+        while(j<html.size() && !isSpace(html.at(j)) && html.at(j)!='>')
+          j++;
+        a.value = html.substr(valueStart, j-valueStart);
+        i = j;
+      }
+    }
+
+    a.raw = html.substr(start, i-start);
+    tag.attributes.push_back(a);
+  }
+
+  return std::string::npos;
+}
+
+//##################################################################################################
+class Optimizer_lt
+{
+public:
+  //################################################################################################
+  Optimizer_lt(const Params_lt& params):
+    m_params(params),
+    m_outputDir(std::filesystem::path(params.outputPath).parent_path())
+  {
+
+  }
+
+  //################################################################################################
+  std::string optimizeHtml(const std::string& html)
+  {
+    std::string out;
+    out.reserve(html.size());
+
+    bool space=false;
+    bool newLine=false;
+    auto flushSpace = [&]
+    {
+      if(space)
+        out += newLine?'\n':' ';
+      space = false;
+      newLine = false;
+    };
+
+    for(size_t i=0; i<html.size();)
+    {
+      char c = html.at(i);
+      if(isSpace(c))
+      {
+        space = true;
+        newLine = newLine || c=='\n';
+        i++;
+        continue;
+      }
+
+      if(c!='<')
+      {
+        flushSpace();
+        out += c;
+        i++;
+        continue;
+      }
+
+      // Comments are removed except for conditional comments.
+      if(startsWith(html, i, "<!--"))
+      {
+        auto end = html.find("-->", i+4);
+        end = (end==std::string::npos)?html.size():end+3;
+        if(startsWith(html, i, "<!--[if"))
+        {
+          flushSpace();
+          out.append(html, i, end-i);
+        }
+        i = end;
+        continue;
+      }
+
+      Tag_lt tag;
+      size_t tagEnd = parseTag(html, i, tag);
+      if(tagEnd==std::string::npos)
+      {
+        flushSpace();
+        out += c;
+        i++;
+        continue;
+      }
+
+      flushSpace();
+      i = tagEnd;
+
+      if(tag.name=="pre" || tag.name=="textarea" || tag.name=="style" || tag.name=="script")
+      {
+        auto close = findCaseInsensitive(html, "</" + tag.name, i);
+        close = (close==std::string::npos)?html.size():close;
+        std::string content = html.substr(i, close-i);
+        i = close;
+
+        if(tag.name=="style")
+        {
+          out += tag.toString();
+          out += processCss(content, m_params.sourceDir, m_params.assetDir + "/");
+        }
+        else if(tag.name=="script")
+          out += processScript(tag, content);
+        else
+        {
+          out += tag.toString();
+          out += content;
+        }
+        continue;
+      }
+
+      if(tag.name=="link")
+      {
+        out += processLink(tag);
+        continue;
+      }
+
+      for(const char* name : {"src", "poster", "href"})
+      {
+        // Links to other pages are left alone, only assets that are loaded by the page are rewritten.
+        if(std::string(name)=="href" && tag.name!="use" && tag.name!="image")
+          continue;
+        if(auto a = tag.find(name); a)
+          rewriteAttribute(*a, m_params.sourceDir, m_params.assetDir + "/", tag.name=="img" || tag.name=="image");
+      }
+      out += tag.toString();
+    }
+
+    return out;
+  }
+
+  //################################################################################################
+  const std::vector<std::string>& written() const
+  {
+    return m_written;
+  }
+
+  //################################################################################################
+  bool failed() const
+  {
+    return m_failed;
+  }
+
+  //################################################################################################
+  //! Pages that share an asset directory each keep a list of the assets that they use, assets that
+  //! a page no longer uses are removed along with their compressed copies unless another page still
+  //! lists them. This stops the asset directory growing each time the content of an asset changes.
+  bool pruneAssets()
+  {
+    auto assetDir = m_outputDir / m_params.assetDir;
+    auto pageName = std::filesystem::path(m_params.outputPath).filename().string();
+    auto listPath = assetDir / ("." + pageName + ".assets");
+
+    std::set<std::string> used;
+    std::string list;
+    for(const auto& i : m_assets)
+    {
+      if(!i.second.empty() && used.insert(i.second).second)
+        list += i.second + "\n";
+    }
+
+    std::set<std::string> old;
+    if(std::string text; readTextFile(listPath.string(), text))
+    {
+      std::stringstream ss(text);
+      for(std::string name; std::getline(ss, name);)
+        if(!name.empty() && !used.count(name))
+          old.insert(name);
+    }
+
+    std::error_code ec;
+    if(used.empty() && old.empty() && !std::filesystem::exists(listPath, ec))
+      return true;
+
+    std::filesystem::create_directories(assetDir, ec);
+    if(!writeTextFile(listPath.string(), list))
+    {
+      std::cerr << "error: Failed to write: " << listPath.string() << std::endl;
+      return false;
+    }
+
+    for(std::filesystem::directory_iterator i(assetDir, ec), end; i!=end && !ec && !old.empty(); i.increment(ec))
+    {
+      auto name = i->path().filename().string();
+      if(name.size()>7 && name.front()=='.' && name.compare(name.size()-7, 7, ".assets")==0 && name!=listPath.filename().string())
+      {
+        std::string text;
+        readTextFile(i->path().string(), text);
+        std::stringstream ss(text);
+        for(std::string other; std::getline(ss, other);)
+          old.erase(other);
+      }
+    }
+
+    for(const auto& name : old)
+      for(const auto& extension : {"", ".gz", ".br"})
+        std::filesystem::remove(assetDir / (name + extension), ec);
+
+    return true;
+  }
+
+private:
+  //################################################################################################
+  std::string processLink(Tag_lt& tag)
+  {
+    auto rel = tag.find("rel");
+    auto href = tag.find("href");
+    if(!href)
+      return tag.toString();
+
+    std::filesystem::path file;
+    if(rel && toLower(rel->value).find("stylesheet")!=std::string::npos && localFile(href->value, m_params.sourceDir, file))
+    {
+      std::string css;
+      if(readTextFile(file.string(), css))
+      {
+        // Inlined styles are relative to the page so their references go through the asset directory.
+        css = processCss(css, file.parent_path(), m_params.assetDir + "/");
+        if(css.size()<=m_params.inlineLimit && css.find("</")==std::string::npos)
+        {
+          std::string style = "<style";
+          if(auto media = tag.find("media"); media)
+            style += " media=\"" + media->value + "\"";
+          return style + ">" + css + "</style>";
+        }
+      }
+    }
+
+    rewriteAttribute(*href, m_params.sourceDir, m_params.assetDir + "/", toLower(rel?rel->value:"").find("icon")!=std::string::npos);
+    return tag.toString();
+  }
+
+  //################################################################################################
+  std::string processScript(Tag_lt& tag, const std::string& content)
+  {
+    auto type = tag.find("type");
+    std::string typeValue = type?toLower(type->value):std::string();
+    bool isJs = typeValue.empty() || typeValue=="module" || typeValue.find("javascript")!=std::string::npos;
+
+    auto src = tag.find("src");
+    if(!src)
+      return tag.toString() + (isJs?minifyJs(content):content);
+
+    // Deferred and async scripts run at a different time when inlined so they keep their file.
+    std::filesystem::path file;
+    if(isJs && !tag.find("defer") && !tag.find("async") && typeValue!="module" && localFile(src->value, m_params.sourceDir, file))
+    {
+      std::string js;
+      if(readTextFile(file.string(), js))
+      {
+        js = minifyJs(js);
+        if(js.size()<=m_params.inlineLimit && findCaseInsensitive(js, "</script", 0)==std::string::npos)
+        {
+          src->remove = true;
+          return tag.toString() + js;
+        }
+      }
+    }
+
+    rewriteAttribute(*src, m_params.sourceDir, m_params.assetDir + "/", false);
+    return tag.toString() + content;
+  }
+
+  //################################################################################################
+  void rewriteAttribute(Attribute_lt& a, const std::filesystem::path& baseDir, const std::string& prefix, bool allowDataUri)
+  {
+    std::string value = rewriteReference(a.value, baseDir, prefix, allowDataUri);
+    if(value != a.value)
+    {
+      a.value = value;
+      a.modified = true;
+    }
+  }
+
+  //################################################################################################
+  //! Minifies a style sheet and rewrites its url() references, prefix is the path from the place
+  //! that the style sheet ends up to the asset directory.
+  std::string processCss(const std::string& css, const std::filesystem::path& baseDir, const std::string& prefix)
+  {
+    std::string text = minifyCss(css);
+    std::string out;
+    out.reserve(text.size());
+
+    size_t pos=0;
+    for(size_t i=findCaseInsensitive(text, "url(", 0); i!=std::string::npos; i=findCaseInsensitive(text, "url(", pos))
+    {
+      size_t start=i+4;
+      auto end = text.find(')', start);
+      if(end==std::string::npos)
+        break;
+
+      std::string quote;
+      std::string url = text.substr(start, end-start);
+      if(!url.empty() && (url.front()=='"' || url.front()=='\'') && url.size()>=2 && url.back()==url.front())
+      {
+        quote = url.substr(0, 1);
+        url = url.substr(1, url.size()-2);
+      }
+
+      out.append(text, pos, start-pos);
+      out += quote + rewriteReference(url, baseDir, prefix, true) + quote + ")";
+      pos = end+1;
+    }
+    out.append(text, pos, std::string::npos);
+    return out;
+  }
+
+  //################################################################################################
+  //! Finds the file that a relative reference points to, absolute and external URLs are ignored.
+  bool localFile(const std::string& url, const std::filesystem::path& baseDir, std::filesystem::path& file) const
+  {
+    if(url.empty() || url.front()=='#' || url.front()=='/' || url.front()=='{')
+      return false;
+
+    auto colon = url.find(':');
+    if(colon!=std::string::npos && url.find_first_of("/?#")>colon)
+      return false;
+
+    std::string path = url.substr(0, url.find_first_of("?#"));
+    file = baseDir / path;
+
+    std::error_code ec;
+    return std::filesystem::is_regular_file(file, ec);
+  }
+
+  //################################################################################################
+  std::string rewriteReference(const std::string& url, const std::filesystem::path& baseDir, const std::string& prefix, bool allowDataUri)
+  {
+    std::filesystem::path file;
+    if(!localFile(url, baseDir, file))
+      return url;
+
+    auto suffixStart = url.find_first_of("?#");
+    std::string suffix = (suffixStart==std::string::npos)?std::string():url.substr(suffixStart);
+
+    std::error_code ec;
+    std::string mime = mimeType(file.extension().string());
+    if(allowDataUri && suffix.empty() && !mime.empty() && std::filesystem::file_size(file, ec)<=m_params.inlineLimit)
+    {
+      std::string data;
+      if(readTextFile(file.string(), data))
+        return "data:" + mime + ";base64," + base64(data);
+    }
+
+    std::string name = assetName(file);
+    return name.empty()?url:(prefix + name + suffix);
+  }
+
+  //################################################################################################
+  //! Writes a file to the asset directory with a name that includes a hash of its contents so that
+  //! it can be cached forever, returns the name relative to the asset directory.
+  std::string assetName(const std::filesystem::path& file)
+  {
+    std::error_code ec;
+    std::string key = std::filesystem::weakly_canonical(file, ec).string();
+    if(auto i = m_assets.find(key); i!=m_assets.end())
+      return i->second;
+
+    // A style sheet that imports itself through other style sheets keeps its original reference.
+    if(m_inProgress.count(key))
+      return std::string();
+    m_inProgress.insert(key);
+
+    std::string content;
+    if(!readTextFile(file.string(), content))
+    {
+      m_inProgress.erase(key);
+      return std::string();
+    }
+
+    std::string extension = file.extension().string();
+    if(toLower(extension)==".css")
+      content = processCss(content, file.parent_path(), std::string());
+    else if(toLower(extension)==".js")
+      content = minifyJs(content);
+
+    std::string name = file.stem().string() + "." + contentHash(content) + extension;
+    auto path = m_outputDir / m_params.assetDir / name;
+
+    // The name changes with the content, so an existing file is already up to date.
+    if(!std::filesystem::exists(path, ec))
+    {
+      std::filesystem::create_directories(path.parent_path(), ec);
+      if(!writeTextFile(path.string(), content))
+      {
+        std::cerr << "error: Failed to write: " << path.string() << std::endl;
+        m_failed = true;
+      }
+    }
+
+    // Images and fonts are already compressed.
+    if(mimeType(extension).empty() || toLower(extension)==".svg")
+      m_written.push_back(path.string());
+
+    m_inProgress.erase(key);
+    m_assets[key] = name;
+    return name;
+  }
+
+  const Params_lt& m_params;
+  std::filesystem::path m_outputDir;
+  std::map<std::string, std::string> m_assets;
+  std::set<std::string> m_inProgress;
+  std::vector<std::string> m_written;
+  bool m_failed{false};
+};
+
+//##################################################################################################
+void printUsage()
+{
+  std::cerr << "Usage: tpPageOptimize [options] <input.html> <output.html>\n"
+               "  Minifies a page and the style sheets and scripts that it uses. Small assets are\n"
+               "  inlined, others are copied next to the page with content hashed names.\n"
+               "  --source-dir=DIR     Directory that references in the page are relative to.\n"
+               "  --asset-dir=NAME     Directory next to the output for hashed assets, default: assets\n"
+               "  --inline-limit=SIZE  Largest asset in bytes to inline, default: 2048\n"
+               "  --list=FILE          Write the path of each file that should be precompressed.\n";
+}
+
+//##################################################################################################
+bool parseArgs(int argc, const char* argv[], Params_lt& params)
+{
+  std::vector<std::string> positional;
+  for(int i=1; i<argc; i++)
+  {
+    std::string arg = argv[i];
+    if(arg.compare(0, 13, "--source-dir=") == 0)
+      params.sourceDir = arg.substr(13);
+    else if(arg.compare(0, 12, "--asset-dir=") == 0)
+      params.assetDir = arg.substr(12);
+    else if(arg.compare(0, 15, "--inline-limit=") == 0)
+      params.inlineLimit = size_t(std::stoul(arg.substr(15)));
+    else if(arg.compare(0, 7, "--list=") == 0)
+      params.listPath = arg.substr(7);
+    else if(arg.compare(0, 1, "-") == 0)
+      return false;
+    else
+      positional.push_back(arg);
+  }
+
+  if(positional.size()!=2)
+    return false;
+
+  params.inputPath = positional.at(0);
+  params.outputPath = positional.at(1);
+  return true;
+}
+}
+
+//##################################################################################################
+int main(int argc, const char* argv[])
+{
+  Params_lt params;
+  if(!parseArgs(argc, argv, params))
+  {
+    printUsage();
+    return 1;
+  }
+
+  std::string html;
+  if(!readTextFile(params.inputPath, html))
+  {
+    std::cerr << "error: Failed to read: " << params.inputPath << std::endl;
+    return 1;
+  }
+
+  Optimizer_lt optimizer(params);
+  html = optimizer.optimizeHtml(html);
+
+  // The page is not written if any of its assets failed so that make builds it again.
+  if(optimizer.failed())
+    return 1;
+
+  if(!writeTextFile(params.outputPath, html))
+  {
+    std::cerr << "error: Failed to write: " << params.outputPath << std::endl;
+    return 1;
+  }
+
+  if(!params.listPath.empty())
+  {
+    std::string list = params.outputPath + "\n";
+    for(const auto& path : optimizer.written())
+      list += path + "\n";
+
+    if(!writeTextFile(params.listPath, list))
+    {
+      std::cerr << "error: Failed to write: " << params.listPath << std::endl;
+      return 1;
+    }
+  }
+
+  return optimizer.pruneAssets()?0:1;
+}
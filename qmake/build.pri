@@ -80,6 +80,12 @@ equals(TEMPLATE, test) {
   IS_TEST = test
 }
 
+equals(TEMPLATE, bench) {
+  TEMPLATE = app
+  IS_BENCH = bench
+  INCLUDEPATH += $$absolute_path(../tp_bench/inc)
+}
+
 # Win32 also needs static libs in libraries
 equals(TEMPLATE, app)|win32 {
   for(LIB, SLIBS) {
@@ -235,12 +241,21 @@ else{
       QMAKE_CXXFLAGS += -fsanitize=thread
       QMAKE_LFLAGS   += -fsanitize=thread
     }
+  }
 
-    tp_prof {
-      #Generate output for prof
-      QMAKE_CXXFLAGS += -pg
-      QMAKE_LFLAGS   += -pg
-    }
+  tp_prof {
+    #Optimized code with frame pointers and debug info so that perf can walk the call stacks, see
+    #tp_prof/profile.sh. This works with multithreaded code unlike -pg.
+    QMAKE_CXXFLAGS += -O2 -g -fno-omit-frame-pointer
+    QMAKE_LFLAGS   += -g
+  }
+
+  linux:tp_release_install {
+    #Release builds keep their debug info and get a build ID, tpInstall strips the installed binaries
+    #and moves the debug info into separate files, see tp_install/split_debug.sh. -O1 and the GNU
+    #hash style make the dynamic symbol tables faster to look up when the binary is loaded.
+    QMAKE_CXXFLAGS_RELEASE += -g
+    QMAKE_LFLAGS_RELEASE   += -Wl,--build-id -Wl,-O1 -Wl,--hash-style=gnu
   }
 }
 
@@ -256,3 +271,4 @@ include(copy.pri)
 include(rc.pri)
 include(static_init.pri)
 include(tr.pri)
+include(telemetry.pri)
@@ -1,22 +1,32 @@
-# Copies the given files to the destination directory
+# Copies the given files or directories to the destination directory
 #Use:
 #TP_COPY += file.xyz
+#
+# tpCopy is built by tp_build/tp_build.pro, it skips files that are already up to date so copydata
+# can run on every build without copying large data again. CONFIG+=tp_copy_hardlink hard links the
+# files instead, a program that writes to one of these also changes the source.
+TP_COPY_TOOL = $$absolute_path($$OUT_PWD/../tpCopy)
+
 defineTest(tpCopy) {
   files = $$1
 
   first.depends = $(first) copydata
   export(first.depends)
 
+  TP_COPY_ARGS =
+  tp_copy_hardlink:TP_COPY_ARGS = --hardlink
+
   DDIR = $$DESTDIR
   win32:DDIR ~= s,/,\\,g
   copydata.commands += $$QMAKE_MKDIR $$quote($$DDIR) $$escape_expand(\\n\\t)
 
   for(FILE, files) {
+    NAME = $$basename(FILE)
 
     # Replace slashes in paths with backslashes for Windows
     win32:FILE ~= s,/,\\,g
 
-    copydata.commands += $$QMAKE_COPY $$quote($$absolute_path(../../$$TARGET/$$FILE)) $$quote($$DDIR) $$escape_expand(\\n\\t)
+    copydata.commands += $$TP_COPY_TOOL $$TP_COPY_ARGS $$quote($$absolute_path(../../$$TARGET/$$FILE)) $$quote($$DDIR/$$NAME) $$escape_expand(\\n\\t)
   }
 
   export(copydata.commands)
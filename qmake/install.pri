@@ -1,5 +1,10 @@
 
 # Copies the given files to the destination directory
+#
+# With CONFIG+=tp_release_install the installed binaries are stripped and their debug info is written
+# to compressed files in <location>/lib/debug/.build-id, see tp_install/split_debug.sh.
+TP_SPLIT_DEBUG = $$absolute_path(../tp_install/split_debug.sh)
+
 defineTest(tpInstall) {
   location = $${1}/
   DESTDIR = $$shadowed($$PWD)
@@ -13,6 +18,17 @@ defineTest(tpInstall) {
 
   INSTALLS += tp_libs tp_bins
 
+  linux:tp_release_install {
+    tp_split_debug.path = $${location}lib/debug
+    tp_split_debug.depends = install_tp_libs install_tp_bins
+    tp_split_debug.extra = bash $$TP_SPLIT_DEBUG $(INSTALL_ROOT)$${location}lib/debug $(INSTALL_ROOT)$${location}bin $(INSTALL_ROOT)$${location}lib
+    INSTALLS += tp_split_debug
+
+    export(tp_split_debug.path)
+    export(tp_split_debug.depends)
+    export(tp_split_debug.extra)
+  }
+
   export(tp_libs.path)
   export(tp_libs.files)
   export(tp_bins.path)
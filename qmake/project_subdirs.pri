@@ -9,3 +9,4 @@ for(SUBPROJECT, SUBPROJECTS) {
 
 include(x_parse_modules_submodules.pri)
 include(x_parse_deps.pri)
+include(x_parse_benchmarks.pri)
@@ -0,0 +1,22 @@
+##Use:
+##CONFIG += tp_telemetry
+
+# Each compile, link, archive and tool runs through tpTelemetry, which appends its wall time, user
+# and system time, peak memory, inputs and outputs to telemetry.log in the top level build
+# directory. This wraps the tp_tr compiler wrapper so it is included after tr.pri. For a summary
+# and a Chrome trace run: tpTelemetry report --trace=telemetry.json telemetry.log
+tp_telemetry:!win32 {
+  TP_TELEMETRY_TOOL = $$absolute_path($$OUT_PWD/../tpTelemetry)
+  TP_TELEMETRY_RUN = $${TP_TELEMETRY_TOOL} run --log=$$absolute_path($$OUT_PWD/../telemetry.log) --
+
+  QMAKE_CC         = $${TP_TELEMETRY_RUN} $${QMAKE_CC}
+  QMAKE_CXX        = $${TP_TELEMETRY_RUN} $${QMAKE_CXX}
+  QMAKE_LINK       = $${TP_TELEMETRY_RUN} $${QMAKE_LINK}
+  QMAKE_LINK_SHLIB = $${TP_TELEMETRY_RUN} $${QMAKE_LINK_SHLIB}
+  QMAKE_AR         = $${TP_TELEMETRY_RUN} $${QMAKE_AR}
+
+  tpRc.commands = $${TP_TELEMETRY_RUN} $${tpRc.commands}
+  contains(QMAKE_EXTRA_COMPILERS, tpStaticInit) {
+    tpStaticInit.commands = $${TP_TELEMETRY_RUN} $${tpStaticInit.commands}
+  }
+}
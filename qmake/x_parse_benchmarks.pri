@@ -0,0 +1,56 @@
+# Collects the modules with TEMPLATE = bench into benchmarks.txt and adds a benchmarks target that
+# runs them all using tp_bench/run_benchmarks.sh. The bench-check target compares the results with
+# the baseline for this machine and bench-baseline replaces the baseline with the results.
+
+include(host_cxx.pri)
+
+# Returns the TEMPLATE and TARGET of a module, TARGET defaults to the name of the directory as it
+# does for the module's own .pro file.
+defineReplace(tpModuleTemplate) {
+  TEMPLATE =
+  TARGET = $$basename(1)
+  include(../../$${1}/vars.pri)
+  isEmpty(TEMPLATE): return()
+  return($$TEMPLATE $$TARGET)
+}
+
+# This is included after x_parse_deps.pri so that each module is only listed once.
+TP_BENCHMARKS =
+for(SUBDIR, SUBDIRS) {
+  equals(SUBDIR, tp_build): next()
+  TP_MODULE_VARS = $$tpModuleTemplate($$SUBDIR)
+  TP_MODULE_TEMPLATE = $$member(TP_MODULE_VARS, 0)
+  equals(TP_MODULE_TEMPLATE, bench) {
+    TP_BENCHMARKS += ./bin/$$member(TP_MODULE_VARS, 1)
+  }
+}
+
+write_file($$OUT_PWD/benchmarks.txt, TP_BENCHMARKS)
+
+benchmarks.depends = first
+benchmarks.commands = $$QMAKE_COPY $$quote($$absolute_path(../tp_bench/run_benchmarks.sh)) $$quote($$OUT_PWD) $$escape_expand(\\n\\t)
+benchmarks.commands += $$quote($$OUT_PWD/run_benchmarks.sh)
+QMAKE_EXTRA_TARGETS += benchmarks
+
+isEmpty(TP_BENCH_MACHINE):      TP_BENCH_MACHINE = $$QMAKE_HOST.name
+isEmpty(TP_BENCH_BASELINE_DIR): TP_BENCH_BASELINE_DIR = $$absolute_path(../../$${PROJECT_DIR}/bench_baselines)
+isEmpty(TP_BENCH_THRESHOLD):    TP_BENCH_THRESHOLD = 5
+isEmpty(TP_BENCH_ALPHA):        TP_BENCH_ALPHA = 0.01
+
+TP_BENCH_CHECK_SOURCE = $$absolute_path(../tp_bench/tp_bench_check.cpp)
+TP_BENCH_CHECK_TOOL = $$OUT_PWD/tpBenchCheck
+TP_BENCH_BASELINE = $$quote($${TP_BENCH_BASELINE_DIR}/$${TP_BENCH_MACHINE})
+
+buildtpbenchcheck.target = $$TP_BENCH_CHECK_TOOL
+buildtpbenchcheck.depends = $$TP_BENCH_CHECK_SOURCE
+buildtpbenchcheck.commands = $$TP_HOST_CXX -std=gnu++1z -O2 $$TP_BENCH_CHECK_SOURCE -o $$TP_BENCH_CHECK_TOOL
+
+benchcheck.target = bench-check
+benchcheck.depends = benchmarks $$TP_BENCH_CHECK_TOOL
+benchcheck.commands = $$TP_BENCH_CHECK_TOOL --threshold=$$TP_BENCH_THRESHOLD --alpha=$$TP_BENCH_ALPHA $$TP_BENCH_BASELINE $$OUT_PWD/bench_results
+
+benchbaseline.target = bench-baseline
+benchbaseline.depends = benchmarks $$TP_BENCH_CHECK_TOOL
+benchbaseline.commands = $$TP_BENCH_CHECK_TOOL --update $$TP_BENCH_BASELINE $$OUT_PWD/bench_results
+
+QMAKE_EXTRA_TARGETS += buildtpbenchcheck benchcheck benchbaseline
@@ -1,4 +1,6 @@
 
+# Modules shared by several SUBPROJECTS are built once, "libA/" and "libA" are the same module.
+SUBDIRS = $$replace(SUBDIRS, /+$, )
 SUBDIRS = $$unique(SUBDIRS)
 
 for(SUBDIR, SUBDIRS) {
@@ -0,0 +1,478 @@
+#ifndef tp_bench_Bench_h
+#define tp_bench_Bench_h
+
+#include "tp_bench/PerfCounters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+//##################################################################################################
+//! A small micro benchmark harness, used by modules with TEMPLATE = bench.
+/*!
+Each benchmark is a function that repeats the code under test while state.keepRunning() returns
+true. The harness picks the number of iterations so that each sample runs for a useful amount of
+time, warms up, then takes a number of samples and reports the time per iteration.
+
+\code
+#include "tp_bench/Bench.h"
+
+TP_BENCH(sortInts, state)
+{
+  std::vector<int> data(1000);
+  while(state.keepRunning())
+  {
+    std::generate(data.begin(), data.end(), std::rand);
+    std::sort(data.begin(), data.end());
+    tp_bench::doNotOptimize(data.data());
+  }
+}
+
+TP_BENCH_MAIN()
+\endcode
+
+Run the binary with --help to see the options, --json=FILE writes the samples and a statistical
+summary of each benchmark. On Linux --perf-counters adds hardware counters per iteration to the
+results and --pin-cpu=N runs the benchmarks on a single CPU.
+*/
+namespace tp_bench
+{
+
+//##################################################################################################
+//! Prevent the compiler from optimizing away the calculation of value.
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+//##################################################################################################
+//! Prevent the compiler from reordering memory accesses across this point.
+inline void clobberMemory()
+{
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : : "memory");
+#endif
+}
+
+//##################################################################################################
+class State
+{
+public:
+  //################################################################################################
+  State(size_t iterations):
+    m_iterations(iterations),
+    m_remaining(iterations)
+  {
+
+  }
+
+  //################################################################################################
+  bool keepRunning()
+  {
+    if(m_remaining==0)
+      return false;
+    m_remaining--;
+    return true;
+  }
+
+  //################################################################################################
+  size_t iterations() const
+  {
+    return m_iterations;
+  }
+
+private:
+  size_t m_iterations;
+  size_t m_remaining;
+};
+
+//##################################################################################################
+struct Benchmark
+{
+  std::string name;
+  std::function<void(State&)> function;
+};
+
+//##################################################################################################
+struct Params
+{
+  std::string jsonFile;
+  std::string filter;
+  size_t repetitions{20};
+  double minSampleSeconds{0.01};
+  double warmupSeconds{0.1};
+  bool list{false};
+  bool perfCounters{false};
+  int pinCpu{-1};
+};
+
+//##################################################################################################
+struct Result
+{
+  std::string name;
+  size_t iterations{0};
+  std::vector<double> samples; //!< Nanoseconds per iteration.
+  double min{0.0};
+  double max{0.0};
+  double mean{0.0};
+  double median{0.0};
+  double stddev{0.0};
+  double mad{0.0};    //!< Median absolute deviation.
+  std::vector<std::pair<std::string, double>> counters; //!< Hardware counters per iteration.
+};
+
+//##################################################################################################
+inline std::vector<Benchmark>& benchmarks()
+{
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+//##################################################################################################
+inline int registerBenchmark(const std::string& name, const std::function<void(State&)>& function)
+{
+  benchmarks().push_back({name, function});
+  return 0;
+}
+
+//##################################################################################################
+//! Returns the nanoseconds per iteration.
+inline double runSample(const Benchmark& benchmark, size_t iterations)
+{
+  State state(iterations);
+  auto start = std::chrono::steady_clock::now();
+  benchmark.function(state);
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end-start).count() / double(iterations);
+}
+
+//##################################################################################################
+inline double median(std::vector<double> values)
+{
+  if(values.empty())
+    return 0.0;
+
+  std::sort(values.begin(), values.end());
+  size_t mid = values.size()/2;
+  return (values.size()%2)?values.at(mid):(values.at(mid-1)+values.at(mid))/2.0;
+}
+
+//##################################################################################################
+inline void calculateStatistics(Result& result)
+{
+  const auto& s = result.samples;
+  if(s.empty())
+    return;
+
+  result.min = *std::min_element(s.begin(), s.end());
+  result.max = *std::max_element(s.begin(), s.end());
+
+  double sum=0.0;
+  for(auto v : s)
+    sum+=v;
+  result.mean = sum / double(s.size());
+
+  double sq=0.0;
+  for(auto v : s)
+    sq += (v-result.mean)*(v-result.mean);
+  result.stddev = (s.size()>1)?std::sqrt(sq/double(s.size()-1)):0.0;
+
+  result.median = median(s);
+
+  std::vector<double> deviations;
+  for(auto v : s)
+    deviations.push_back(std::fabs(v-result.median));
+  result.mad = median(deviations);
+}
+
+//##################################################################################################
+inline Result runBenchmark(const Benchmark& benchmark, const Params& params)
+{
+  Result result;
+  result.name = benchmark.name;
+
+  // Calibrate, find the number of iterations that takes at least minSampleSeconds.
+  size_t iterations=1;
+  for(;;)
+  {
+    double seconds = runSample(benchmark, iterations) * double(iterations) / 1e9;
+    if(seconds>=params.minSampleSeconds || iterations>=(size_t(1)<<40))
+      break;
+
+    double scale = (seconds>0.0)?(params.minSampleSeconds*1.2/seconds):10.0;
+    iterations = size_t(double(iterations) * std::clamp(scale, 2.0, 10.0));
+  }
+  result.iterations = iterations;
+
+  // Warm up caches, branch predictors and CPU frequency.
+  auto warmupEnd = std::chrono::steady_clock::now() + std::chrono::duration<double>(params.warmupSeconds);
+  while(std::chrono::steady_clock::now()<warmupEnd)
+    runSample(benchmark, iterations);
+
+  std::unique_ptr<PerfCounters> counters;
+  if(params.perfCounters)
+  {
+    counters = std::make_unique<PerfCounters>();
+    counters->start();
+  }
+
+  for(size_t r=0; r<params.repetitions; r++)
+    result.samples.push_back(runSample(benchmark, iterations));
+
+  if(counters)
+  {
+    counters->stop();
+    double total = double(iterations) * double(params.repetitions);
+    for(const auto& [name, value] : counters->read())
+      result.counters.emplace_back(name, value/total);
+  }
+
+  calculateStatistics(result);
+  return result;
+}
+
+//##################################################################################################
+//! Control characters are not allowed in JSON strings, they are written as \u00XX.
+inline std::string escapeJSON(const std::string& text)
+{
+  static const char* digits = "0123456789abcdef";
+  std::string result;
+  for(char c : text)
+  {
+    switch(c)
+    {
+    case '"':  result += "\\\""; break;
+    case '\\': result += "\\\\"; break;
+    case '\n': result += "\\n";  break;
+    case '\r': result += "\\r";  break;
+    case '\t': result += "\\t";  break;
+    default:
+      if(uint8_t(c)<0x20)
+      {
+        result += "\\u00";
+        result += digits[uint8_t(c)>>4];
+        result += digits[uint8_t(c)&0xF];
+      }
+      else
+        result += c;
+    }
+  }
+  return result;
+}
+
+//##################################################################################################
+inline std::string hostName()
+{
+#ifndef _WIN32
+  char buffer[256]={0};
+  if(gethostname(buffer, sizeof(buffer)-1) == 0)
+    return buffer;
+#endif
+  if(const char* name = std::getenv("COMPUTERNAME"); name)
+    return name;
+  return "unknown";
+}
+
+//##################################################################################################
+inline void writeJSON(const std::vector<Result>& results, const std::string& executable, const std::string& fileName)
+{
+  std::ofstream out(fileName);
+  out << std::setprecision(9);
+
+  out << "{\n";
+  out << "  \"context\": {\"executable\": \"" << escapeJSON(executable) << "\", "
+      << "\"host\": \"" << escapeJSON(hostName()) << "\", "
+      << "\"time\": " << std::time(nullptr) << "},\n";
+
+  out << "  \"benchmarks\": [\n";
+  for(size_t i=0; i<results.size(); i++)
+  {
+    const auto& r = results.at(i);
+    out << "    {\"name\": \"" << escapeJSON(r.name) << "\", "
+        << "\"unit\": \"ns\", "
+        << "\"iterations\": " << r.iterations << ", "
+        << "\"repetitions\": " << r.samples.size() << ", "
+        << "\"min\": " << r.min << ", "
+        << "\"median\": " << r.median << ", "
+        << "\"mean\": " << r.mean << ", "
+        << "\"max\": " << r.max << ", "
+        << "\"stddev\": " << r.stddev << ", "
+        << "\"mad\": " << r.mad << ", "
+        << "\"samples\": [";
+    for(size_t s=0; s<r.samples.size(); s++)
+      out << (s?", ":"") << r.samples.at(s);
+    out << "]";
+
+    if(!r.counters.empty())
+    {
+      out << ", \"counters\": {";
+      for(size_t c=0; c<r.counters.size(); c++)
+        out << (c?", ":"") << "\"" << r.counters.at(c).first << "\": " << r.counters.at(c).second;
+      out << "}";
+    }
+
+    out << "}" << (((i+1)<results.size())?",":"") << "\n";
+  }
+  out << "  ]\n}\n";
+}
+
+//##################################################################################################
+inline std::string formatTime(double ns)
+{
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(2);
+  if(ns<1e3)
+    ss << ns << " ns";
+  else if(ns<1e6)
+    ss << ns/1e3 << " us";
+  else if(ns<1e9)
+    ss << ns/1e6 << " ms";
+  else
+    ss << ns/1e9 << " s";
+  return ss.str();
+}
+
+//##################################################################################################
+inline void printUsage()
+{
+  std::cerr << "Usage: <benchmark> [options]\n"
+               "  --json=FILE          Write the results to a JSON file.\n"
+               "  --filter=TEXT        Only run benchmarks with names that contain TEXT.\n"
+               "  --repetitions=N      Number of samples to take, default: 20\n"
+               "  --min-time=SECONDS   Minimum duration of each sample, default: 0.01\n"
+               "  --warmup=SECONDS     Time to run before taking samples, default: 0.1\n"
+               "  --list               List the benchmarks and exit.\n"
+               "  --perf-counters      Record hardware performance counters (Linux only).\n"
+               "  --pin-cpu=N          Run the benchmarks on CPU N.\n";
+}
+
+//##################################################################################################
+inline bool parseArgs(int argc, char* argv[], Params& params)
+{
+  auto startsWith = [](const std::string& arg, const std::string& prefix)
+  {
+    return arg.compare(0, prefix.size(), prefix) == 0;
+  };
+
+  try
+  {
+    for(int i=1; i<argc; i++)
+    {
+      std::string arg = argv[i];
+      if(startsWith(arg, "--json="))
+        params.jsonFile = arg.substr(7);
+      else if(startsWith(arg, "--filter="))
+        params.filter = arg.substr(9);
+      else if(startsWith(arg, "--repetitions="))
+        params.repetitions = std::max(size_t(1), size_t(std::stoul(arg.substr(14))));
+      else if(startsWith(arg, "--min-time="))
+        params.minSampleSeconds = std::stod(arg.substr(11));
+      else if(startsWith(arg, "--warmup="))
+        params.warmupSeconds = std::stod(arg.substr(9));
+      else if(arg == "--list")
+        params.list = true;
+      else if(arg == "--perf-counters")
+        params.perfCounters = true;
+      else if(startsWith(arg, "--pin-cpu="))
+        params.pinCpu = std::stoi(arg.substr(10));
+      else
+        return false;
+    }
+  }
+  catch(...)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+inline int runBenchmarks(int argc, char* argv[])
+{
+  Params params;
+  if(!parseArgs(argc, argv, params))
+  {
+    printUsage();
+    return 1;
+  }
+
+  if(params.pinCpu>=0 && !pinToCpu(params.pinCpu))
+    std::cerr << "warning: Failed to pin benchmarks to CPU " << params.pinCpu << std::endl;
+
+  for(const auto& [cpu, governor] : checkGovernors(params.pinCpu))
+    std::cerr << "warning: CPU " << cpu << " is using the " << governor << " frequency governor, results will be noisy." << std::endl;
+
+  if(params.perfCounters && !params.list && !PerfCounters().isValid())
+    std::cerr << "warning: Some performance counters are not available, check /proc/sys/kernel/perf_event_paranoid" << std::endl;
+
+  std::vector<Result> results;
+  for(const auto& benchmark : benchmarks())
+  {
+    if(!params.filter.empty() && benchmark.name.find(params.filter) == std::string::npos)
+      continue;
+
+    if(params.list)
+    {
+      std::cout << benchmark.name << std::endl;
+      continue;
+    }
+
+    const auto& r = results.emplace_back(runBenchmark(benchmark, params));
+    std::cout << std::left << std::setw(40) << r.name
+              << " median: " << std::setw(12) << formatTime(r.median)
+              << " min: " << std::setw(12) << formatTime(r.min)
+              << " stddev: " << std::setw(12) << formatTime(r.stddev)
+              << " iterations: " << r.iterations << "x" << r.samples.size() << std::endl;
+
+    if(!r.counters.empty())
+    {
+      std::cout << std::setw(40) << "";
+      for(const auto& [name, value] : r.counters)
+        std::cout << " " << name << ": " << std::fixed << std::setprecision(2) << value << std::defaultfloat;
+      std::cout << std::endl;
+    }
+  }
+
+  if(!params.jsonFile.empty())
+    writeJSON(results, (argc>0)?argv[0]:"", params.jsonFile);
+
+  return 0;
+}
+}
+
+//##################################################################################################
+#define TP_BENCH(NAME, STATE) \
+  static void tp_bench_##NAME(tp_bench::State&); \
+  [[maybe_unused]] static int tp_bench_##NAME##_registered = tp_bench::registerBenchmark(#NAME, tp_bench_##NAME); \
+  static void tp_bench_##NAME([[maybe_unused]] tp_bench::State& STATE)
+
+//##################################################################################################
+#define TP_BENCH_MAIN() \
+  int main(int argc, char* argv[]) \
+  { \
+    return tp_bench::runBenchmarks(argc, argv); \
+  }
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef tp_bench_PerfCounters_h
+#define tp_bench_PerfCounters_h
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+//##################################################################################################
+//! Hardware performance counters using perf_event_open, these are only available on Linux.
+/*!
+The counters can measure the calling thread (pid=0) or another process, tpTest uses the latter with
+enableOnExec to count everything that a test does. Opening the counters can fail if
+/proc/sys/kernel/perf_event_paranoid does not allow it or when running in a container, in that case
+isValid() returns false and the measurements should be reported without counters.
+*/
+namespace tp_bench
+{
+
+//##################################################################################################
+class PerfCounters
+{
+public:
+  //################################################################################################
+  //! Open the counters for pid, 0 is the calling thread.
+  PerfCounters(int pid=0, bool enableOnExec=false)
+  {
+#ifdef __linux__
+    auto add = [&](const char* name, uint32_t type, uint64_t config)
+    {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      attr.disabled = 1;
+      attr.inherit = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.enable_on_exec = enableOnExec?1:0;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      int fd = int(syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0));
+      if(fd>=0)
+        m_counters.emplace_back(name, fd);
+      else
+        m_valid = false;
+    };
+
+    m_valid = true;
+    add("cycles",       PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    add("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    add("cacheMisses",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    add("branchMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    add("pageFaults",   PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+#else
+    (void)pid;
+    (void)enableOnExec;
+#endif
+  }
+
+  //################################################################################################
+  ~PerfCounters()
+  {
+#ifdef __linux__
+    for(const auto& counter : m_counters)
+      close(counter.second);
+#endif
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  //################################################################################################
+  //! True if all of the counters could be opened.
+  bool isValid() const
+  {
+    return m_valid;
+  }
+
+  //################################################################################################
+  void start()
+  {
+#ifdef __linux__
+    for(const auto& counter : m_counters)
+    {
+      ioctl(counter.second, PERF_EVENT_IOC_RESET, 0);
+      ioctl(counter.second, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  //################################################################################################
+  void stop()
+  {
+#ifdef __linux__
+    for(const auto& counter : m_counters)
+      ioctl(counter.second, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+  }
+
+  //################################################################################################
+  //! Returns the name and value of each counter, scaled if the counters were multiplexed.
+  std::vector<std::pair<std::string, double>> read() const
+  {
+    std::vector<std::pair<std::string, double>> values;
+#ifdef __linux__
+    for(const auto& counter : m_counters)
+    {
+      uint64_t data[3]={0,0,0};
+      if(::read(counter.second, data, sizeof(data)) != ssize_t(sizeof(data)))
+        continue;
+
+      double value = double(data[0]);
+      if(data[2]>0 && data[2]<data[1])
+        value *= double(data[1]) / double(data[2]);
+      values.emplace_back(counter.first, value);
+    }
+#endif
+    return values;
+  }
+
+private:
+  std::vector<std::pair<std::string, int>> m_counters;
+  bool m_valid{false};
+};
+
+//##################################################################################################
+//! Pin the calling thread to a single CPU, returns false if this is not supported.
+inline bool pinToCpu(int cpu)
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+//##################################################################################################
+//! Returns the CPUs that are not using the performance frequency governor, -1 checks all CPUs.
+/*!
+Other governors change the clock speed during the measurement which adds noise to the results.
+CPUs that don't expose a governor are assumed to be fine.
+*/
+inline std::vector<std::pair<int, std::string>> checkGovernors(int cpu=-1)
+{
+  std::vector<std::pair<int, std::string>> results;
+
+  int first = (cpu<0)?0:cpu;
+  int last  = (cpu<0)?int(std::thread::hardware_concurrency()):(cpu+1);
+  for(int c=first; c<last; c++)
+  {
+    std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(c) + "/cpufreq/scaling_governor");
+    std::string governor;
+    if(in >> governor && governor != "performance")
+      results.emplace_back(c, governor);
+  }
+
+  return results;
+}
+}
+
+#endif
@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# Runs each of the benchmarks listed in benchmarks.txt and writes the results for each one to
+# bench_results/<name>.json, any arguments are passed on to the benchmarks.
+#   ./run_benchmarks.sh --repetitions=50
+
+cd "$(dirname "$0")"
+
+mkdir -p bench_results
+
+benchCommands=`cat benchmarks.txt`
+
+failed=0
+results="\nBenchmark Results:\n"
+for benchCommand in ${benchCommands[@]}; do
+  echo -e "\n\e[1;93mRunning benchmark: \e[21m${benchCommand}\e[39m"
+
+  name=`basename "${benchCommand}"`
+  if ${benchCommand} --json="bench_results/${name}.json" "$@"; then
+    results="${results}    \e[32mPassed: ${benchCommand}\e[39m\n"
+  else
+    results="${results}    \e[31mFailed: ${benchCommand}\e[39m\n"
+    failed=1
+  fi
+done
+
+echo -e "${results}"
+exit ${failed}
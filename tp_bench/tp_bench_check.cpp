@@ -0,0 +1,553 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <filesystem>
+#include <cstdlib>
+#include <cctype>
+#include <cstdint>
+
+namespace
+{
+
+//##################################################################################################
+//! Just enough JSON to read the output of tp_bench.
+struct JSON_lt
+{
+  enum class Type
+  {
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object
+  };
+
+  Type type{Type::Null};
+  bool boolean{false};
+  double number{0.0};
+  std::string string;
+  std::vector<JSON_lt> array;
+  std::map<std::string, JSON_lt> object;
+
+  //################################################################################################
+  const JSON_lt& operator[](const std::string& key) const
+  {
+    static const JSON_lt null;
+    auto i = object.find(key);
+    return (i!=object.end())?i->second:null;
+  }
+};
+
+//##################################################################################################
+class JSONParser_lt
+{
+public:
+  //################################################################################################
+  JSONParser_lt(const std::string& text):
+    m_text(text)
+  {
+
+  }
+
+  //################################################################################################
+  bool parse(JSON_lt& value)
+  {
+    return parseValue(value);
+  }
+
+private:
+  //################################################################################################
+  void skipWhitespace()
+  {
+    while(m_i<m_text.size() && std::isspace(uint8_t(m_text.at(m_i))))
+      m_i++;
+  }
+
+  //################################################################################################
+  bool consume(char c)
+  {
+    skipWhitespace();
+    if(m_i<m_text.size() && m_text.at(m_i) == c)
+    {
+      m_i++;
+      return true;
+    }
+    return false;
+  }
+
+  //################################################################################################
+  bool parseString(std::string& result)
+  {
+    if(!consume('"'))
+      return false;
+
+    for(; m_i<m_text.size(); m_i++)
+    {
+      char c = m_text.at(m_i);
+      if(c=='"')
+      {
+        m_i++;
+        return true;
+      }
+
+      if(c=='\\' && (m_i+1)<m_text.size())
+      {
+        m_i++;
+        c = m_text.at(m_i);
+        switch(c)
+        {
+        case 'n': c='\n'; break;
+        case 't': c='\t'; break;
+        case 'r': c='\r'; break;
+        case 'u':
+        {
+          // Characters outside of the ASCII range are written as UTF-8.
+          if(m_i+4>=m_text.size())
+            return false;
+          unsigned long code = std::strtoul(m_text.substr(m_i+1, 4).c_str(), nullptr, 16);
+          m_i += 4;
+          if(code<0x80)
+            c = char(code);
+          else
+          {
+            if(code<0x800)
+              result += char(0xC0 | (code>>6));
+            else
+            {
+              result += char(0xE0 | (code>>12));
+              result += char(0x80 | ((code>>6) & 0x3F));
+            }
+            c = char(0x80 | (code & 0x3F));
+          }
+          break;
+        }
+        default: break;
+        }
+      }
+      result += c;
+    }
+    return false;
+  }
+
+  //################################################################################################
+  bool parseValue(JSON_lt& value)
+  {
+    skipWhitespace();
+    if(m_i>=m_text.size())
+      return false;
+
+    char c = m_text.at(m_i);
+    if(c=='{')
+    {
+      m_i++;
+      value.type = JSON_lt::Type::Object;
+      if(consume('}'))
+        return true;
+      do
+      {
+        std::string key;
+        if(!parseString(key) || !consume(':') || !parseValue(value.object[key]))
+          return false;
+      }
+      while(consume(','));
+      return consume('}');
+    }
+
+    if(c=='[')
+    {
+      m_i++;
+      value.type = JSON_lt::Type::Array;
+      if(consume(']'))
+        return true;
+      do
+      {
+        if(!parseValue(value.array.emplace_back()))
+          return false;
+      }
+      while(consume(','));
+      return consume(']');
+    }
+
+    if(c=='"')
+    {
+      value.type = JSON_lt::Type::String;
+      return parseString(value.string);
+    }
+
+    auto startsWith = [&](const std::string& word)
+    {
+      if(m_text.compare(m_i, word.size(), word) != 0)
+        return false;
+      m_i += word.size();
+      return true;
+    };
+
+    if(startsWith("true"))
+    {
+      value.type = JSON_lt::Type::Bool;
+      value.boolean = true;
+      return true;
+    }
+
+    if(startsWith("false"))
+    {
+      value.type = JSON_lt::Type::Bool;
+      return true;
+    }
+
+    if(startsWith("null"))
+      return true;
+
+    size_t end=m_i;
+    while(end<m_text.size() && std::string("+-0123456789.eE").find(m_text.at(end)) != std::string::npos)
+      end++;
+
+    if(end==m_i)
+      return false;
+
+    try
+    {
+      value.type = JSON_lt::Type::Number;
+      value.number = std::stod(m_text.substr(m_i, end-m_i));
+    }
+    catch(...)
+    {
+      return false;
+    }
+
+    m_i = end;
+    return true;
+  }
+
+  const std::string& m_text;
+  size_t m_i{0};
+};
+
+//##################################################################################################
+struct Benchmark_lt
+{
+  double median{0.0};
+  std::vector<double> samples;
+  std::map<std::string, double> counters;
+};
+
+//##################################################################################################
+struct Comparison_lt
+{
+  std::string name;
+  double baseline{0.0};
+  double current{0.0};
+  double change{0.0}; //!< Percent, positive is slower.
+  double pValue{1.0};
+  std::string status;
+  std::vector<std::pair<std::string, double>> counterChanges; //!< Percent change of each counter.
+};
+
+//##################################################################################################
+struct Params_lt
+{
+  std::string baselineDirectory;
+  std::string resultsDirectory;
+  double threshold{5.0};
+  double alpha{0.01};
+  bool update{false};
+};
+
+//##################################################################################################
+bool readTextFile(const std::string& fileName, std::string& results)
+{
+  std::ifstream in(fileName, std::ios::binary);
+  if(!in)
+    return false;
+
+  std::stringstream ss;
+  ss << in.rdbuf();
+  results = ss.str();
+  return true;
+}
+
+//##################################################################################################
+//! Load the benchmarks from a tp_bench JSON file, the names are prefixed with the file name.
+bool loadResults(const std::filesystem::path& path, std::map<std::string, Benchmark_lt>& benchmarks)
+{
+  std::string text;
+  if(!readTextFile(path.string(), text))
+    return false;
+
+  JSON_lt json;
+  if(!JSONParser_lt(text).parse(json))
+  {
+    std::cerr << "error: Failed to parse: " << path.string() << std::endl;
+    return false;
+  }
+
+  std::string prefix = path.stem().string() + "/";
+  for(const auto& b : json["benchmarks"].array)
+  {
+    auto& benchmark = benchmarks[prefix + b["name"].string];
+    benchmark.median = b["median"].number;
+    for(const auto& sample : b["samples"].array)
+      benchmark.samples.push_back(sample.number);
+    for(const auto& [counter, value] : b["counters"].object)
+      benchmark.counters[counter] = value.number;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+//! Two sided Mann-Whitney U test, returns the p-value that a and b come from the same distribution.
+double mannWhitneyU(const std::vector<double>& a, const std::vector<double>& b)
+{
+  if(a.empty() || b.empty())
+    return 1.0;
+
+  std::vector<std::pair<double, int>> all;
+  for(auto v : a)
+    all.emplace_back(v, 0);
+  for(auto v : b)
+    all.emplace_back(v, 1);
+  std::sort(all.begin(), all.end());
+
+  double n1 = double(a.size());
+  double n2 = double(b.size());
+  double n = n1+n2;
+
+  // Rank with ties given the average rank, accumulating the tie correction term.
+  double rankSumA=0.0;
+  double ties=0.0;
+  for(size_t i=0; i<all.size();)
+  {
+    size_t j=i;
+    while(j<all.size() && all.at(j).first == all.at(i).first)
+      j++;
+
+    double rank = (double(i+1) + double(j)) / 2.0;
+    for(size_t k=i; k<j; k++)
+      if(all.at(k).second == 0)
+        rankSumA += rank;
+
+    double t = double(j-i);
+    ties += t*t*t - t;
+    i=j;
+  }
+
+  double u = rankSumA - n1*(n1+1.0)/2.0;
+  double mu = n1*n2/2.0;
+  double sigma = std::sqrt(n1*n2/12.0 * ((n+1.0) - ties/(n*(n-1.0))));
+  if(sigma<=0.0)
+    return 1.0;
+
+  double z = (std::fabs(u-mu) - 0.5) / sigma;
+  if(z<0.0)
+    z=0.0;
+
+  return std::erfc(z/std::sqrt(2.0));
+}
+
+//##################################################################################################
+void printUsage()
+{
+  std::cerr << "Usage: tpBenchCheck [options] <baseline directory> <results directory>\n"
+               "  Compares the tp_bench JSON results against a stored baseline and fails if any\n"
+               "  benchmark is significantly slower.\n"
+               "  --threshold=PERCENT  Fail if the median is this much slower, default: 5\n"
+               "  --alpha=P            Significance level for the Mann-Whitney U test, default: 0.01\n"
+               "  --update             Copy the results into the baseline directory.\n";
+}
+
+//##################################################################################################
+bool parseArgs(int argc, const char* argv[], Params_lt& params)
+{
+  auto startsWith = [](const std::string& arg, const std::string& prefix)
+  {
+    return arg.compare(0, prefix.size(), prefix) == 0;
+  };
+
+  std::vector<std::string> positional;
+  try
+  {
+    for(int i=1; i<argc; i++)
+    {
+      std::string arg = argv[i];
+      if(startsWith(arg, "--threshold="))
+        params.threshold = std::stod(arg.substr(12));
+      else if(startsWith(arg, "--alpha="))
+        params.alpha = std::stod(arg.substr(8));
+      else if(arg == "--update")
+        params.update = true;
+      else if(startsWith(arg, "-"))
+        return false;
+      else
+        positional.push_back(arg);
+    }
+  }
+  catch(...)
+  {
+    return false;
+  }
+
+  if(positional.size()!=2)
+    return false;
+
+  params.baselineDirectory = positional.at(0);
+  params.resultsDirectory = positional.at(1);
+  return true;
+}
+
+//##################################################################################################
+std::vector<std::filesystem::path> listResults(const std::string& directory)
+{
+  std::vector<std::filesystem::path> files;
+  std::error_code ec;
+  for(const auto& entry : std::filesystem::directory_iterator(directory, ec))
+    if(entry.path().extension() == ".json")
+      files.push_back(entry.path());
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+//##################################################################################################
+int update(const Params_lt& params)
+{
+  std::error_code ec;
+  std::filesystem::create_directories(params.baselineDirectory, ec);
+
+  for(const auto& file : listResults(params.resultsDirectory))
+  {
+    auto destination = std::filesystem::path(params.baselineDirectory) / file.filename();
+    std::filesystem::copy_file(file, destination, std::filesystem::copy_options::overwrite_existing, ec);
+    if(ec)
+    {
+      std::cerr << "error: Failed to copy " << file.string() << " to " << destination.string() << std::endl;
+      return 1;
+    }
+    std::cout << "Updated baseline: " << destination.string() << std::endl;
+  }
+
+  return 0;
+}
+}
+
+//##################################################################################################
+int main(int argc, const char* argv[])
+{
+  Params_lt params;
+  if(!parseArgs(argc, argv, params))
+  {
+    printUsage();
+    return 1;
+  }
+
+  if(params.update)
+    return update(params);
+
+  std::map<std::string, Benchmark_lt> baseline;
+  std::map<std::string, Benchmark_lt> current;
+  for(const auto& file : listResults(params.resultsDirectory))
+  {
+    loadResults(file, current);
+    loadResults(std::filesystem::path(params.baselineDirectory) / file.filename(), baseline);
+  }
+
+  if(current.empty())
+  {
+    std::cerr << "error: No benchmark results found in: " << params.resultsDirectory << std::endl;
+    return 1;
+  }
+
+  std::vector<Comparison_lt> comparisons;
+  size_t regressions=0;
+  for(const auto& [name, result] : current)
+  {
+    Comparison_lt& c = comparisons.emplace_back();
+    c.name = name;
+    c.current = result.median;
+
+    auto i = baseline.find(name);
+    if(i == baseline.end())
+    {
+      c.status = "new";
+      continue;
+    }
+
+    c.baseline = i->second.median;
+    c.change = (c.baseline>0.0)?((c.current-c.baseline)/c.baseline*100.0):0.0;
+    c.pValue = mannWhitneyU(i->second.samples, result.samples);
+
+    for(const auto& [counter, value] : result.counters)
+    {
+      auto b = i->second.counters.find(counter);
+      if(b != i->second.counters.end() && b->second>0.0)
+        c.counterChanges.emplace_back(counter, (value-b->second)/b->second*100.0);
+    }
+
+    bool significant = c.pValue<params.alpha;
+    if(significant && c.change>params.threshold)
+    {
+      c.status = "REGRESSION";
+      regressions++;
+    }
+    else if(significant && c.change<-params.threshold)
+      c.status = "improved";
+    else
+      c.status = "ok";
+  }
+
+  // Largest slow downs first.
+  std::stable_sort(comparisons.begin(), comparisons.end(), [](const auto& a, const auto& b)
+  {
+    return a.change>b.change;
+  });
+
+  std::cout << std::left << std::setw(50) << "Benchmark"
+            << std::right << std::setw(16) << "Baseline (ns)"
+            << std::setw(16) << "Current (ns)"
+            << std::setw(10) << "Change"
+            << std::setw(10) << "p-value"
+            << "  Status\n";
+
+  std::cout << std::fixed;
+  for(const auto& c : comparisons)
+  {
+    bool isNew = (c.status == "new");
+    std::string color = (c.status=="REGRESSION")?"\033[31m":(c.status=="improved")?"\033[32m":"";
+    std::cout << color << std::left << std::setw(50) << c.name << std::right
+              << std::setw(16) << std::setprecision(2) << c.baseline
+              << std::setw(16) << c.current;
+    if(isNew)
+      std::cout << std::setw(10) << "-" << std::setw(10) << "-";
+    else
+      std::cout << std::setw(9) << std::showpos << std::setprecision(1) << c.change << std::noshowpos << "%"
+                << std::setw(10) << std::setprecision(4) << c.pValue;
+    std::cout << "  " << c.status << (color.empty()?"":"\033[39m") << "\n";
+  }
+
+  // The counters help tell an algorithmic change (instructions) from a memory layout change (cache
+  // misses, page faults) when the instruction count is stable.
+  bool first=true;
+  for(const auto& c : comparisons)
+  {
+    if(c.counterChanges.empty())
+      continue;
+
+    if(first)
+      std::cout << "\nPerformance counter changes per iteration:\n";
+    first=false;
+
+    std::cout << std::left << std::setw(50) << c.name << std::right;
+    for(const auto& [counter, change] : c.counterChanges)
+      std::cout << "  " << counter << ": " << std::showpos << std::setprecision(1) << change << std::noshowpos << "%";
+    std::cout << "\n";
+  }
+
+  std::cout << std::defaultfloat << "\n" << regressions << " regression(s), threshold: " << params.threshold << "%, alpha: " << params.alpha << std::endl;
+  return regressions?1:0;
+}
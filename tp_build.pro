@@ -10,7 +10,26 @@ buildtprc.output = $${TP_RC_TOOL}
 buildtprc.target = buildtprc
 buildtprc.commands = $$TP_HOST_CXX -std=gnu++1z -O2 $$TP_RC_TOOL_SOURCE -o $$TP_RC_TOOL
 
-PRE_TARGETDEPS += buildtprc
-QMAKE_EXTRA_TARGETS += buildtprc
+TP_COPY_TOOL_SOURCE = $$absolute_path(tp_copy/tp_copy.cpp)
+TP_COPY_TOOL = $$absolute_path($$OUT_PWD/../tpCopy)
+
+buildtpcopy.output = $${TP_COPY_TOOL}
+buildtpcopy.target = buildtpcopy
+buildtpcopy.commands = $$TP_HOST_CXX -std=gnu++1z -O2 $$TP_COPY_TOOL_SOURCE -o $$TP_COPY_TOOL
+
+PRE_TARGETDEPS += buildtprc buildtpcopy
+QMAKE_EXTRA_TARGETS += buildtprc buildtpcopy
+
+tp_telemetry {
+  TP_TELEMETRY_TOOL_SOURCE = $$absolute_path(tp_telemetry/tp_telemetry.cpp)
+  TP_TELEMETRY_TOOL = $$absolute_path($$OUT_PWD/../tpTelemetry)
+
+  buildtptelemetry.output = $${TP_TELEMETRY_TOOL}
+  buildtptelemetry.target = buildtptelemetry
+  buildtptelemetry.commands = $$TP_HOST_CXX -std=gnu++1z -O2 $$TP_TELEMETRY_TOOL_SOURCE -o $$TP_TELEMETRY_TOOL
+
+  PRE_TARGETDEPS += buildtptelemetry
+  QMAKE_EXTRA_TARGETS += buildtptelemetry
+}
 
 SOURCES += qmake/tp_build.cpp
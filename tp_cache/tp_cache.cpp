@@ -0,0 +1,881 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <algorithm>
+#include <filesystem>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+//##################################################################################################
+struct Params_lt
+{
+  std::string command;              //!< run, stats or trim.
+  fs::path cacheDir;
+  fs::path sharedDir;
+  fs::path root;
+  fs::path buildRoot;
+  fs::path output;
+  uint64_t maxSize{0};
+  bool verbose{false};
+  std::vector<std::string> positional;
+};
+
+//##################################################################################################
+//! Files in the cache entry of a command, the depfile has its paths replaced with placeholders so
+//! that the entry can be used from a different checkout or build directory.
+struct Entry_lt
+{
+  std::string output;
+  std::string depFile;
+  bool hasDepFile{false};
+};
+
+//##################################################################################################
+//! The files that a compile read, as listed in its depfile, and the hash of each when it ran.
+struct Dependency_lt
+{
+  std::string path;
+  std::string hash;
+};
+
+//##################################################################################################
+//! A manifest lists the results of a command line, one for each set of dependencies that it has been
+//! compiled with. The result whose dependencies all still have the same contents is used.
+struct ManifestResult_lt
+{
+  std::string key;
+  std::vector<Dependency_lt> dependencies;
+};
+
+//##################################################################################################
+class SHA256_lt
+{
+public:
+  //################################################################################################
+  void add(const void* data, size_t size)
+  {
+    auto bytes = static_cast<const uint8_t*>(data);
+    m_length += size;
+    while(size>0)
+    {
+      size_t n = std::min(size, 64-m_used);
+      std::memcpy(m_block+m_used, bytes, n);
+      m_used += n;
+      bytes += n;
+      size -= n;
+      if(m_used == 64)
+      {
+        process(m_block);
+        m_used = 0;
+      }
+    }
+  }
+
+  //################################################################################################
+  void add(const std::string& text)
+  {
+    add(text.data(), text.size());
+    add("\0", 1);
+  }
+
+  //################################################################################################
+  std::string hex()
+  {
+    uint64_t bits = m_length*8;
+    uint8_t pad = 0x80;
+    add(&pad, 1);
+    pad = 0;
+    while(m_used != 56)
+      add(&pad, 1);
+    for(int i=7; i>=0; i--)
+    {
+      uint8_t b = uint8_t(bits>>(i*8));
+      add(&b, 1);
+    }
+
+    std::string result;
+    const char* digits = "0123456789abcdef";
+    for(uint32_t h : m_h)
+      for(int i=28; i>=0; i-=4)
+        result.push_back(digits[(h>>i)&0xF]);
+    return result;
+  }
+
+private:
+  //################################################################################################
+  static uint32_t rotr(uint32_t x, int n)
+  {
+    return (x>>n) | (x<<(32-n));
+  }
+
+  //################################################################################################
+  void process(const uint8_t* block)
+  {
+    static const uint32_t k[64] =
+    {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+      0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+      0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+      0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+      0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    uint32_t w[64];
+    for(int i=0; i<16; i++)
+      w[i] = uint32_t(block[i*4])<<24 | uint32_t(block[i*4+1])<<16 | uint32_t(block[i*4+2])<<8 | uint32_t(block[i*4+3]);
+    for(int i=16; i<64; i++)
+    {
+      uint32_t s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15]>>3);
+      uint32_t s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2]>>10);
+      w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+
+    uint32_t a=m_h[0], b=m_h[1], c=m_h[2], d=m_h[3], e=m_h[4], f=m_h[5], g=m_h[6], h=m_h[7];
+    for(int i=0; i<64; i++)
+    {
+      uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e&f) ^ (~e&g)) + k[i] + w[i];
+      uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a&b) ^ (a&c) ^ (b&c));
+      h=g; g=f; f=e; e=d+t1; d=c; c=b; b=a; a=t1+t2;
+    }
+
+    m_h[0]+=a; m_h[1]+=b; m_h[2]+=c; m_h[3]+=d; m_h[4]+=e; m_h[5]+=f; m_h[6]+=g; m_h[7]+=h;
+  }
+
+  uint32_t m_h[8]{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  uint8_t m_block[64]{};
+  size_t m_used{0};
+  uint64_t m_length{0};
+};
+
+//##################################################################################################
+bool readFile(const fs::path& path, std::string& results)
+{
+  std::ifstream in(path, std::ios::binary);
+  if(!in)
+    return false;
+
+  std::stringstream ss;
+  ss << in.rdbuf();
+  results = ss.str();
+  return true;
+}
+
+//##################################################################################################
+//! Written next to the destination and renamed so that a reader never sees half a file, this also
+//! makes it safe for several builds to write the same entry to a shared cache.
+bool writeFile(const fs::path& path, const std::string& data)
+{
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+
+  fs::path tmp = path;
+  tmp += ".tpcache" + std::to_string(
+#ifndef _WIN32
+        getpid()
+#else
+        0
+#endif
+        );
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    if(!out || !out.write(data.data(), std::streamsize(data.size())))
+    {
+      fs::remove(tmp, ec);
+      return false;
+    }
+  }
+
+  fs::rename(tmp, path, ec);
+  if(ec)
+  {
+    fs::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
+//##################################################################################################
+void hashFile(SHA256_lt& hash, const fs::path& path)
+{
+  std::ifstream in(path, std::ios::binary);
+  std::vector<char> buffer(1<<16);
+  while(in)
+  {
+    in.read(buffer.data(), std::streamsize(buffer.size()));
+    hash.add(buffer.data(), size_t(in.gcount()));
+  }
+}
+
+//##################################################################################################
+std::string replaceAll(std::string text, const std::string& from, const std::string& to)
+{
+  if(from.empty())
+    return text;
+
+  for(size_t pos=text.find(from); pos!=std::string::npos; pos=text.find(from, pos+to.size()))
+    text.replace(pos, from.size(), to);
+  return text;
+}
+
+//##################################################################################################
+fs::path findExecutable(const std::string& name)
+{
+  if(name.find('/') != std::string::npos)
+    return name;
+
+  if(const char* path = std::getenv("PATH"); path)
+  {
+    std::stringstream ss(path);
+    std::string dir;
+    while(std::getline(ss, dir, ':'))
+    {
+      std::error_code ec;
+      fs::path candidate = fs::path(dir.empty()?".":dir) / name;
+      if(fs::is_regular_file(candidate, ec))
+        return candidate;
+    }
+  }
+  return fs::path();
+}
+
+//##################################################################################################
+int execute(const std::vector<std::string>& args)
+{
+#ifndef _WIN32
+  std::vector<char*> argv;
+  for(const auto& arg : args)
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  argv.push_back(nullptr);
+
+  pid_t pid = fork();
+  if(pid<0)
+  {
+    std::cerr << "error: Failed to run: " << args.front() << std::endl;
+    return 1;
+  }
+
+  if(pid==0)
+  {
+    execvp(argv.front(), argv.data());
+    std::cerr << "error: Failed to run: " << args.front() << ": " << std::strerror(errno) << std::endl;
+    _exit(127);
+  }
+
+  int status=0;
+  while(waitpid(pid, &status, 0)<0)
+    if(errno != EINTR)
+      return 1;
+  return WIFEXITED(status)?WEXITSTATUS(status):1;
+#else
+  std::string command;
+  for(const auto& arg : args)
+    command += "\"" + arg + "\" ";
+  return std::system(command.c_str());
+#endif
+}
+
+//##################################################################################################
+//! Finds the files that a compiler writes, -o and the -MF depfile.
+void findOutputs(const std::vector<std::string>& args, std::string& output, std::string& depFile)
+{
+  for(size_t i=1; i<args.size(); i++)
+  {
+    const auto& arg = args.at(i);
+    if((arg == "-o" || arg == "-MF") && i+1<args.size())
+      (arg=="-o"?output:depFile) = args.at(++i);
+    else if(arg.size()>2 && arg.compare(0, 2, "-o") == 0)
+      output = arg.substr(2);
+    else if(arg.size()>3 && arg.compare(0, 3, "-MF") == 0)
+      depFile = arg.substr(3);
+  }
+}
+
+//##################################################################################################
+//! Paths that differ between checkouts and build directories are replaced with placeholders.
+std::string normalize(const Params_lt& params, std::string text, const std::string& output, const std::string& depFile)
+{
+  if(!depFile.empty())
+    text = replaceAll(text, depFile, "@DEPFILE@");
+  text = replaceAll(text, output, "@OUTPUT@");
+  if(!params.buildRoot.empty())
+    text = replaceAll(text, params.buildRoot.string(), "@BUILD@");
+  return replaceAll(text, params.root.string(), "@ROOT@");
+}
+
+//##################################################################################################
+std::string restorePaths(const Params_lt& params, std::string text, const std::string& output)
+{
+  text = replaceAll(text, "@OUTPUT@", output);
+  text = replaceAll(text, "@BUILD@", params.buildRoot.string());
+  return replaceAll(text, "@ROOT@", params.root.string());
+}
+
+//##################################################################################################
+//! The key of a command is the compiler, the command line and the contents of every file named on
+//! the command line, the sources and generated sources of a compile and the objects of an archive.
+//! The headers that a compile includes are checked against its manifest.
+std::string commandKey(const Params_lt& params, const std::vector<std::string>& args, const std::string& output, const std::string& depFile)
+{
+  SHA256_lt hash;
+  hash.add("tpCache command 2");
+
+  std::error_code ec;
+  if(auto compiler = findExecutable(args.front()); !compiler.empty())
+    hashFile(hash, compiler);
+
+  for(size_t i=1; i<args.size(); i++)
+  {
+    const auto& arg = args.at(i);
+    hash.add(normalize(params, arg, output, depFile));
+    if(arg == output || arg == depFile)
+      continue;
+
+    fs::path path = (arg.size()>1 && arg.front()=='@')?fs::path(arg.substr(1)):fs::path(arg);
+    if(!arg.empty() && arg.front() != '-' && fs::is_regular_file(path, ec))
+      hashFile(hash, path);
+  }
+
+  return hash.hex();
+}
+
+//##################################################################################################
+//! Reads the prerequisites of a Makefile style depfile, targets are the words that end in ':'.
+std::vector<std::string> parseDepFile(const std::string& text)
+{
+  std::vector<std::string> paths;
+  std::set<std::string> seen;
+  std::string word;
+  auto finish = [&]
+  {
+    if(!word.empty() && word.back()!=':' && seen.insert(word).second)
+      paths.push_back(word);
+    word.clear();
+  };
+
+  for(size_t i=0; i<text.size(); i++)
+  {
+    char c = text.at(i);
+    char next = (i+1<text.size())?text.at(i+1):'\0';
+    if(c=='\\' && (next==' ' || next=='#'))
+      word.push_back(text.at(++i));
+    else if(c=='$' && next=='$')
+      word.push_back(text.at(++i));
+    else if(c=='\\' && (next=='\n' || next=='\r'))
+      finish();
+    else if(c==' ' || c=='\t' || c=='\n' || c=='\r')
+      finish();
+    else
+      word.push_back(c);
+  }
+  finish();
+  return paths;
+}
+
+//##################################################################################################
+//! Hashes are kept for the life of the process as a header is checked against many results.
+std::string dependencyHash(std::map<std::string, std::string>& hashes, const std::string& path)
+{
+  auto& result = hashes[path];
+  if(result.empty())
+  {
+    std::error_code ec;
+    if(fs::is_regular_file(path, ec))
+    {
+      SHA256_lt hash;
+      hashFile(hash, path);
+      result = hash.hex();
+    }
+    else
+      result = "missing";
+  }
+  return result;
+}
+
+//##################################################################################################
+//! The key of the files a command wrote, this is the same for any build that compiles the same
+//! command line with the same dependencies.
+std::string resultKey(const std::string& key, const std::vector<Dependency_lt>& dependencies)
+{
+  SHA256_lt hash;
+  hash.add("tpCache result 1");
+  hash.add(key);
+  for(const auto& dependency : dependencies)
+  {
+    hash.add(dependency.path);
+    hash.add(dependency.hash);
+  }
+  return hash.hex();
+}
+
+//##################################################################################################
+std::string encodeManifest(const std::vector<ManifestResult_lt>& results)
+{
+  std::string data = "tpCache manifest 1\n";
+  for(const auto& result : results)
+  {
+    data += "result " + result.key + " " + std::to_string(result.dependencies.size()) + "\n";
+    for(const auto& dependency : result.dependencies)
+      data += dependency.hash + " " + dependency.path + "\n";
+  }
+  return data;
+}
+
+//##################################################################################################
+bool decodeManifest(const std::string& data, std::vector<ManifestResult_lt>& results)
+{
+  std::istringstream in(data);
+  std::string line;
+  if(!std::getline(in, line) || line != "tpCache manifest 1")
+    return false;
+
+  while(std::getline(in, line))
+  {
+    std::istringstream header(line);
+    std::string role;
+    size_t count=0;
+    ManifestResult_lt result;
+    if(!(header >> role >> result.key >> count) || role != "result")
+      return false;
+
+    for(size_t i=0; i<count; i++)
+    {
+      size_t space = std::string::npos;
+      if(!std::getline(in, line) || (space=line.find(' ')) == std::string::npos)
+        return false;
+      result.dependencies.push_back({line.substr(space+1), line.substr(0, space)});
+    }
+    results.push_back(std::move(result));
+  }
+  return true;
+}
+
+//##################################################################################################
+std::string encodeEntry(const Entry_lt& entry)
+{
+  std::string data = "tpCache 1\n";
+  data += "output " + std::to_string(entry.output.size()) + "\n" + entry.output;
+  if(entry.hasDepFile)
+    data += "depfile " + std::to_string(entry.depFile.size()) + "\n" + entry.depFile;
+  return data;
+}
+
+//##################################################################################################
+bool decodeEntry(const std::string& data, Entry_lt& entry)
+{
+  std::string header = "tpCache 1\n";
+  if(data.compare(0, header.size(), header) != 0)
+    return false;
+
+  bool hasOutput=false;
+  size_t pos = header.size();
+  while(pos<data.size())
+  {
+    auto space = data.find(' ', pos);
+    auto newLine = data.find('\n', pos);
+    if(space == std::string::npos || newLine == std::string::npos || space>newLine)
+      return false;
+
+    std::string role = data.substr(pos, space-pos);
+    size_t size = size_t(std::strtoull(data.c_str()+space+1, nullptr, 10));
+    pos = newLine+1;
+    if(pos+size>data.size())
+      return false;
+
+    if(role == "output")
+    {
+      entry.output = data.substr(pos, size);
+      hasOutput = true;
+    }
+    else if(role == "depfile")
+    {
+      entry.depFile = data.substr(pos, size);
+      entry.hasDepFile = true;
+    }
+    pos += size;
+  }
+  return hasOutput;
+}
+
+//##################################################################################################
+fs::path entryPath(const fs::path& dir, const std::string& key)
+{
+  return dir / key.substr(0, 2) / key;
+}
+
+//##################################################################################################
+fs::path manifestPath(const fs::path& dir, const std::string& key)
+{
+  auto path = entryPath(dir, key);
+  path += ".manifest";
+  return path;
+}
+
+//##################################################################################################
+//! Finds the result in a manifest whose dependencies all have the same contents that they do now.
+bool findResult(const Params_lt& params, const fs::path& dir, const std::string& key, std::map<std::string, std::string>& hashes, ManifestResult_lt& found)
+{
+  std::string data;
+  std::vector<ManifestResult_lt> results;
+  if(dir.empty() || !readFile(manifestPath(dir, key), data) || !decodeManifest(data, results))
+    return false;
+
+  for(auto& result : results)
+  {
+    bool match = true;
+    for(size_t i=0; match && i<result.dependencies.size(); i++)
+    {
+      const auto& dependency = result.dependencies.at(i);
+      match = dependencyHash(hashes, restorePaths(params, dependency.path, std::string())) == dependency.hash;
+    }
+
+    if(match)
+    {
+      found = std::move(result);
+      return true;
+    }
+  }
+  return false;
+}
+
+//##################################################################################################
+//! Adds a result to the front of a manifest, results that have not been added recently fall off the
+//! end.
+void addResult(const fs::path& dir, const std::string& key, const ManifestResult_lt& result)
+{
+  static const size_t maxResults=16;
+
+  std::string data;
+  std::vector<ManifestResult_lt> results;
+  if(readFile(manifestPath(dir, key), data) && !decodeManifest(data, results))
+    results.clear();
+
+  results.erase(std::remove_if(results.begin(), results.end(), [&](const auto& r){return r.key == result.key;}), results.end());
+  results.insert(results.begin(), result);
+  if(results.size()>maxResults)
+    results.resize(maxResults);
+
+  writeFile(manifestPath(dir, key), encodeManifest(results));
+}
+
+//##################################################################################################
+//! Looks in the local cache then the shared one, entries found in the shared cache are copied to the
+//! local cache. The time of an entry is updated each time it is used so that trim keeps the most
+//! recently used entries.
+bool lookupEntry(const Params_lt& params, const std::string& key, Entry_lt& entry)
+{
+  std::string data;
+  std::error_code ec;
+  auto local = entryPath(params.cacheDir, key);
+  if(readFile(local, data) && decodeEntry(data, entry))
+  {
+    fs::last_write_time(local, fs::file_time_type::clock::now(), ec);
+    return true;
+  }
+
+  if(!params.sharedDir.empty() && readFile(entryPath(params.sharedDir, key), data) && decodeEntry(data, entry))
+  {
+    writeFile(local, data);
+    return true;
+  }
+
+  return false;
+}
+
+//##################################################################################################
+//! Finds the manifest result of a command whose dependencies have not changed, then its entry.
+bool lookup(const Params_lt& params, const std::string& key, Entry_lt& entry)
+{
+  std::error_code ec;
+  std::map<std::string, std::string> hashes;
+  if(ManifestResult_lt result; findResult(params, params.cacheDir, key, hashes, result))
+  {
+    fs::last_write_time(manifestPath(params.cacheDir, key), fs::file_time_type::clock::now(), ec);
+    if(lookupEntry(params, result.key, entry))
+      return true;
+  }
+
+  if(ManifestResult_lt result; findResult(params, params.sharedDir, key, hashes, result) && lookupEntry(params, result.key, entry))
+  {
+    addResult(params.cacheDir, key, result);
+    return true;
+  }
+
+  return false;
+}
+
+//##################################################################################################
+int run(const Params_lt& params)
+{
+  auto args = params.positional;
+  std::string output = params.output.string();
+  std::string depFile;
+  findOutputs(args, output, depFile);
+
+  // Without an output there is nothing to look up and a compile without a depfile can't be checked
+  // against the headers that it includes, these are just run.
+  bool compile = std::find(args.begin(), args.end(), "-c") != args.end();
+  if(output.empty() || (compile && depFile.empty()))
+    return execute(args);
+
+  std::string key = commandKey(params, args, output, depFile);
+
+  if(Entry_lt entry; lookup(params, key, entry))
+  {
+    bool ok = writeFile(output, entry.output);
+    if(ok && entry.hasDepFile && !depFile.empty())
+      ok = writeFile(depFile, restorePaths(params, entry.depFile, output));
+
+    if(ok)
+    {
+      if(params.verbose)
+        std::cout << "tpCache: hit " << output << std::endl;
+      return 0;
+    }
+  }
+
+  if(params.verbose)
+    std::cout << "tpCache: miss " << output << std::endl;
+
+  // -MMD leaves system headers out of the depfile, they are needed to check the result next time.
+  std::replace(args.begin(), args.end(), std::string("-MMD"), std::string("-MD"));
+
+  auto start = fs::file_time_type::clock::now();
+  if(int result = execute(args); result != 0)
+    return result;
+
+  Entry_lt entry;
+  if(!readFile(output, entry.output))
+    return 0;
+
+  ManifestResult_lt result;
+  if(!depFile.empty() && readFile(depFile, entry.depFile))
+  {
+    std::map<std::string, std::string> hashes;
+    for(const auto& path : parseDepFile(entry.depFile))
+    {
+      // A dependency that changed while the command ran may not match the output.
+      std::error_code ec;
+      if(auto time = fs::last_write_time(path, ec); !ec && time>=start)
+        return 0;
+      result.dependencies.push_back({normalize(params, path, std::string(), std::string()), dependencyHash(hashes, path)});
+    }
+
+    entry.depFile = normalize(params, entry.depFile, output, std::string());
+    entry.hasDepFile = true;
+  }
+  else if(compile)
+    return 0;
+
+  result.key = resultKey(key, result.dependencies);
+
+  // A cache that can't be written to doesn't fail the build.
+  std::string data = encodeEntry(entry);
+  if(!writeFile(entryPath(params.cacheDir, result.key), data))
+    std::cerr << "warning: Failed to write to the build cache: " << params.cacheDir.string() << std::endl;
+  addResult(params.cacheDir, key, result);
+
+  if(!params.sharedDir.empty())
+  {
+    writeFile(entryPath(params.sharedDir, result.key), data);
+    addResult(params.sharedDir, key, result);
+  }
+
+  return 0;
+}
+
+//##################################################################################################
+struct CacheFile_lt
+{
+  fs::path path;
+  uint64_t size{0};
+  fs::file_time_type time;
+};
+
+//##################################################################################################
+std::vector<CacheFile_lt> listEntries(const fs::path& dir)
+{
+  std::vector<CacheFile_lt> entries;
+  std::error_code ec;
+  for(fs::recursive_directory_iterator i(dir, ec), end; i!=end && !ec; i.increment(ec))
+    if(i->is_regular_file(ec))
+      entries.push_back({i->path(), uint64_t(i->file_size(ec)), i->last_write_time(ec)});
+  return entries;
+}
+
+//##################################################################################################
+int stats(const Params_lt& params)
+{
+  uint64_t size=0;
+  auto entries = listEntries(params.cacheDir);
+  for(const auto& entry : entries)
+    size += entry.size;
+
+  std::cout << params.cacheDir.string() << ": " << entries.size() << " entries, " << (size+1023)/1024 << " KiB" << std::endl;
+  return 0;
+}
+
+//##################################################################################################
+//! Removes the least recently used entries until the cache is smaller than the max size.
+int trim(const Params_lt& params)
+{
+  uint64_t size=0;
+  auto entries = listEntries(params.cacheDir);
+  for(const auto& entry : entries)
+    size += entry.size;
+
+  std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b){return a.time<b.time;});
+
+  size_t removed=0;
+  for(const auto& entry : entries)
+  {
+    if(size<=params.maxSize)
+      break;
+
+    std::error_code ec;
+    if(fs::remove(entry.path, ec))
+    {
+      size -= entry.size;
+      removed++;
+    }
+  }
+
+  std::cout << params.cacheDir.string() << ": removed " << removed << " entries" << std::endl;
+  return 0;
+}
+
+//##################################################################################################
+void printUsage()
+{
+  std::cerr << "Usage: tpCache <command> [options]\n"
+               "  A content addressed cache of the objects and archives of each module.\n"
+               "\n"
+               "  tpCache run --cache-dir=DIR --root=DIR [options] -- <command...>\n"
+               "    Runs a compile or archive command, or restores its output from the cache. Compiles\n"
+               "    are checked against the contents of each file listed in their depfile.\n"
+               "    --shared-dir=DIR   A second cache, shared with other checkouts or machines.\n"
+               "    --build-root=DIR   Top level build directory, replaced in cached depfiles.\n"
+               "    --output=FILE      The file the command writes, defaults to the -o argument.\n"
+               "    --verbose          Print each hit and miss.\n"
+               "\n"
+               "  tpCache stats --cache-dir=DIR\n"
+               "  tpCache trim --cache-dir=DIR --max-size=SIZE[K|M|G]\n"
+               "    Removes the least recently used entries until the cache fits in SIZE.\n";
+}
+
+//##################################################################################################
+uint64_t parseSize(const std::string& text)
+{
+  size_t end=0;
+  uint64_t size = std::stoull(text, &end);
+  std::string suffix = text.substr(end);
+  if(suffix == "K")
+    size <<= 10;
+  else if(suffix == "M")
+    size <<= 20;
+  else if(suffix == "G")
+    size <<= 30;
+  else if(!suffix.empty())
+    throw std::invalid_argument(text);
+  return size;
+}
+
+//##################################################################################################
+bool parseArgs(int argc, const char* argv[], Params_lt& params)
+{
+  if(argc<2)
+    return false;
+
+  params.command = argv[1];
+  for(int i=2; i<argc; i++)
+  {
+    std::string arg = argv[i];
+    if(arg == "--" && params.command == "run")
+    {
+      for(i++; i<argc; i++)
+        params.positional.push_back(argv[i]);
+    }
+    else if(arg.compare(0, 12, "--cache-dir=") == 0)
+      params.cacheDir = arg.substr(12);
+    else if(arg.compare(0, 13, "--shared-dir=") == 0)
+      params.sharedDir = arg.substr(13);
+    else if(arg.compare(0, 7, "--root=") == 0)
+      params.root = arg.substr(7);
+    else if(arg.compare(0, 13, "--build-root=") == 0)
+      params.buildRoot = arg.substr(13);
+    else if(arg.compare(0, 9, "--output=") == 0)
+      params.output = arg.substr(9);
+    else if(arg.compare(0, 11, "--max-size=") == 0)
+    {
+      try
+      {
+        params.maxSize = parseSize(arg.substr(11));
+      }
+      catch(...)
+      {
+        return false;
+      }
+    }
+    else if(arg == "--verbose")
+      params.verbose = true;
+    else if(arg.compare(0, 1, "-") == 0)
+      return false;
+    else
+      params.positional.push_back(arg);
+  }
+
+  // Paths are compared and replaced as strings so they need to be in the same form.
+  std::error_code ec;
+  if(!params.root.empty())
+    params.root = fs::weakly_canonical(params.root, ec);
+  if(!params.buildRoot.empty())
+    params.buildRoot = fs::weakly_canonical(params.buildRoot, ec);
+
+  if(params.command == "run")
+    return !params.cacheDir.empty() && !params.root.empty() && !params.positional.empty();
+
+  if(params.command == "stats")
+    return !params.cacheDir.empty();
+
+  if(params.command == "trim")
+    return !params.cacheDir.empty() && params.maxSize>0;
+
+  return false;
+}
+}
+
+//##################################################################################################
+int main(int argc, const char* argv[])
+{
+  Params_lt params;
+  if(!parseArgs(argc, argv, params))
+  {
+    printUsage();
+    return 1;
+  }
+
+  if(params.command == "run")
+    return run(params);
+
+  if(params.command == "stats")
+    return stats(params);
+
+  return trim(params);
+}
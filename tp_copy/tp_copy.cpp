@@ -0,0 +1,319 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#endif
+
+#ifdef __APPLE__
+#include <sys/clonefile.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+//##################################################################################################
+struct Params_lt
+{
+  fs::path source;
+  fs::path destination;
+  size_t jobs{0};
+  bool hardLink{false};
+  bool verbose{false};
+};
+
+//##################################################################################################
+struct Copy_lt
+{
+  fs::path source;
+  fs::path destination;
+};
+
+//##################################################################################################
+struct Counts_lt
+{
+  std::atomic<size_t> upToDate{0};
+  std::atomic<size_t> linked{0};
+  std::atomic<size_t> cloned{0};
+  std::atomic<size_t> copied{0};
+  std::atomic<size_t> failed{0};
+  size_t removed{0};
+};
+
+//##################################################################################################
+bool sameContents(const fs::path& a, const fs::path& b)
+{
+  std::ifstream inA(a, std::ios::binary);
+  std::ifstream inB(b, std::ios::binary);
+  if(!inA || !inB)
+    return false;
+
+  std::vector<char> bufferA(1<<16);
+  std::vector<char> bufferB(1<<16);
+  for(;;)
+  {
+    inA.read(bufferA.data(), std::streamsize(bufferA.size()));
+    inB.read(bufferB.data(), std::streamsize(bufferB.size()));
+    if(inA.gcount() != inB.gcount())
+      return false;
+    if(inA.gcount() == 0)
+      return true;
+    if(!std::equal(bufferA.begin(), bufferA.begin()+inA.gcount(), bufferB.begin()))
+      return false;
+  }
+}
+
+//##################################################################################################
+//! Copy on write clone of the file, this only works if both are on a file system that supports it
+//! (Btrfs, XFS, APFS, ...). The clone gets the permissions of the source as a copy would.
+bool cloneFile(const fs::path& source, const fs::path& destination)
+{
+#if defined(__linux__) && defined(FICLONE)
+  int in = open(source.c_str(), O_RDONLY);
+  if(in<0)
+    return false;
+
+  int out = open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(out<0)
+  {
+    close(in);
+    return false;
+  }
+
+  struct stat st;
+  bool ok = ioctl(out, FICLONE, in) == 0 && fstat(in, &st) == 0 && fchmod(out, st.st_mode & 07777) == 0;
+  close(out);
+  close(in);
+  if(!ok)
+    unlink(destination.c_str());
+  return ok;
+#elif defined(__APPLE__)
+  return clonefile(source.c_str(), destination.c_str(), 0) == 0;
+#else
+  (void)source;
+  (void)destination;
+  return false;
+#endif
+}
+
+//##################################################################################################
+//! Files are the same if the destination is a link to the source or has the same size and time,
+//! copies are given the time of the source so this is true of anything copied by tpCopy. Files with
+//! a different time are compared so that touching a large source doesn't copy it again.
+bool upToDate(const Copy_lt& copy)
+{
+  std::error_code ec;
+  if(!fs::exists(copy.destination, ec))
+    return false;
+
+  if(fs::equivalent(copy.source, copy.destination, ec))
+    return true;
+
+  if(fs::file_size(copy.source, ec) != fs::file_size(copy.destination, ec) || ec)
+    return false;
+
+  auto time = fs::last_write_time(copy.source, ec);
+  if(!ec && time == fs::last_write_time(copy.destination, ec))
+    return true;
+
+  if(!sameContents(copy.source, copy.destination))
+    return false;
+
+  fs::last_write_time(copy.destination, time, ec);
+  return true;
+}
+
+//##################################################################################################
+void copyFile(const Params_lt& params, const Copy_lt& copy, Counts_lt& counts)
+{
+  if(upToDate(copy))
+  {
+    counts.upToDate++;
+    return;
+  }
+
+  std::error_code ec;
+  fs::create_directories(copy.destination.parent_path(), ec);
+
+  // The old file is removed rather than written to, it may be a hard link to an older source.
+  fs::remove(copy.destination, ec);
+
+  if(params.hardLink)
+  {
+    fs::create_hard_link(copy.source, copy.destination, ec);
+    if(!ec)
+    {
+      counts.linked++;
+      return;
+    }
+  }
+
+  // Written next to the destination and renamed so that an interrupted copy is not mistaken for a
+  // complete one.
+  fs::path tmp = copy.destination;
+  tmp += ".tpcopy";
+  fs::remove(tmp, ec);
+
+  bool cloned = cloneFile(copy.source, tmp);
+  if(!cloned && !fs::copy_file(copy.source, tmp, fs::copy_options::overwrite_existing, ec))
+  {
+    std::cerr << "error: Failed to copy " << copy.source.string() << " to " << copy.destination.string() << ": " << ec.message() << std::endl;
+    counts.failed++;
+    return;
+  }
+
+  fs::last_write_time(tmp, fs::last_write_time(copy.source, ec), ec);
+  fs::rename(tmp, copy.destination, ec);
+  if(ec)
+  {
+    std::cerr << "error: Failed to write " << copy.destination.string() << ": " << ec.message() << std::endl;
+    fs::remove(tmp, ec);
+    counts.failed++;
+    return;
+  }
+
+  (cloned?counts.cloned:counts.copied)++;
+  if(params.verbose)
+    std::cout << copy.source.string() << " -> " << copy.destination.string() << std::endl;
+}
+
+//##################################################################################################
+//! The destination of a directory copy mirrors the source, files and directories that are no longer
+//! in the source are removed.
+void prune(const Params_lt& params, Counts_lt& counts)
+{
+  std::error_code ec;
+  std::vector<fs::path> stale;
+  for(fs::recursive_directory_iterator i(params.destination, ec), end; i!=end && !ec; i.increment(ec))
+  {
+    if(fs::exists(fs::symlink_status(params.source / fs::relative(i->path(), params.destination, ec), ec)))
+      continue;
+
+    stale.push_back(i->path());
+    i.disable_recursion_pending();
+  }
+
+  for(const auto& path : stale)
+  {
+    counts.removed += size_t(fs::remove_all(path, ec));
+    if(params.verbose)
+      std::cout << "removed " << path.string() << std::endl;
+  }
+}
+
+//##################################################################################################
+void printUsage()
+{
+  std::cerr << "Usage: tpCopy [options] <source> <destination>\n"
+               "  Copies a file, or a directory tree into the destination directory. Files that are\n"
+               "  already up to date are skipped, copies are cloned where the file system supports it.\n"
+               "  Files in a destination directory that are not in the source are removed.\n"
+               "  --jobs=N      Files to copy at the same time, defaults to the number of CPUs.\n"
+               "  --hardlink    Hard link files instead of copying them where possible. Writing to a\n"
+               "                linked file also changes the source.\n"
+               "  --verbose     Print each file that is copied.\n";
+}
+
+//##################################################################################################
+bool parseArgs(int argc, const char* argv[], Params_lt& params)
+{
+  std::vector<std::string> positional;
+  for(int i=1; i<argc; i++)
+  {
+    std::string arg = argv[i];
+    if(arg.compare(0, 7, "--jobs=") == 0)
+      params.jobs = size_t(std::stoul(arg.substr(7)));
+    else if(arg == "--hardlink")
+      params.hardLink = true;
+    else if(arg == "--verbose")
+      params.verbose = true;
+    else if(arg.compare(0, 1, "-") == 0)
+      return false;
+    else
+      positional.push_back(arg);
+  }
+
+  if(positional.size()!=2)
+    return false;
+
+  params.source = positional.at(0);
+  params.destination = positional.at(1);
+
+  if(params.jobs==0)
+    params.jobs = std::max(1u, std::thread::hardware_concurrency());
+
+  return true;
+}
+}
+
+//##################################################################################################
+int main(int argc, const char* argv[])
+{
+  Params_lt params;
+  if(!parseArgs(argc, argv, params))
+  {
+    printUsage();
+    return 1;
+  }
+
+  std::error_code ec;
+  std::vector<Copy_lt> copies;
+  bool directory = fs::is_directory(params.source, ec);
+  if(directory)
+  {
+    for(fs::recursive_directory_iterator i(params.source, ec), end; i!=end && !ec; i.increment(ec))
+      if(i->is_regular_file(ec))
+        copies.push_back({i->path(), params.destination / fs::relative(i->path(), params.source, ec)});
+  }
+  else if(fs::is_regular_file(params.source, ec))
+    copies.push_back({params.source, params.destination});
+  else
+  {
+    std::cerr << "error: Source not found: " << params.source.string() << std::endl;
+    return 1;
+  }
+
+  Counts_lt counts;
+  std::atomic<size_t> next{0};
+  auto worker = [&]
+  {
+    for(size_t i=next++; i<copies.size(); i=next++)
+      copyFile(params, copies.at(i), counts);
+  };
+
+  std::vector<std::thread> threads;
+  size_t threadCount = std::min(params.jobs, copies.size());
+  for(size_t i=1; i<threadCount; i++)
+    threads.emplace_back(worker);
+  worker();
+  for(auto& thread : threads)
+    thread.join();
+
+  if(directory)
+    prune(params, counts);
+
+  if(copies.size()>1 && (counts.upToDate != copies.size() || counts.removed>0))
+  {
+    std::cout << "tpCopy: " << params.destination.string() << ": "
+              << counts.copied << " copied, "
+              << counts.cloned << " cloned, "
+              << counts.linked << " linked, "
+              << counts.upToDate << " up to date, "
+              << counts.removed << " removed" << std::endl;
+  }
+
+  return (counts.failed>0)?1:0;
+}
@@ -0,0 +1,27 @@
+#!/bin/bash
+
+# Runs a build command and appends its start and end time in milliseconds to a log in the format of
+# .ninja_log, so that tpCriticalPath reads the times of gmake builds the same way as ninja builds.
+#   time_command.sh <log> <output> <command...>
+
+LOG=$1
+OUTPUT=$2
+shift
+shift
+
+now()
+{
+  local t=$(date +%s%3N)
+  if [[ "${t}" == *N ]]; then
+    t=$(( $(date +%s) * 1000 ))
+  fi
+  echo ${t}
+}
+
+START=$(now)
+"$@"
+STATUS=$?
+END=$(now)
+
+printf '%s\t%s\t0\t%s\t0\n' "${START}" "${END}" "${OUTPUT}" >> "${LOG}"
+exit ${STATUS}
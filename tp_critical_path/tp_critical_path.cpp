@@ -0,0 +1,628 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <queue>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <iomanip>
+#include <cstdint>
+#include <tuple>
+#include <functional>
+
+namespace
+{
+
+//##################################################################################################
+struct Params_lt
+{
+  std::vector<std::string> logFiles;
+  std::vector<std::string> modules;
+  std::string buildDir;
+  std::string traceFile;
+  std::string traceModel{"unified"};
+  std::vector<size_t> cores{1, 2, 4, 8, 16, 32};
+  size_t traceCores{0};
+  size_t top{10};
+};
+
+//##################################################################################################
+struct Module_lt
+{
+  std::string name;
+  std::string target;
+  std::vector<std::string> dependencies;
+  std::set<size_t> allDependencies; //!< Transitive, indexes into the module list.
+  std::vector<size_t> tasks;
+  size_t finalTask{SIZE_MAX};      //!< The archive or link.
+  bool isLib{false};
+};
+
+//##################################################################################################
+struct Task_lt
+{
+  std::string output;
+  size_t module{SIZE_MAX};
+  int64_t duration{0};             //!< Milliseconds.
+  std::vector<size_t> dependencies;
+  std::vector<size_t> dependents;
+  int64_t bottomLevel{0};          //!< Longest path from the start of this task to the end.
+};
+
+//##################################################################################################
+struct Schedule_lt
+{
+  int64_t makespan{0};
+  std::vector<int64_t> start;
+  std::vector<size_t> core;
+};
+
+//##################################################################################################
+std::string formatTime(int64_t ms)
+{
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(1) << double(ms)/1000.0 << " s";
+  return ss.str();
+}
+
+//##################################################################################################
+std::vector<std::string> splitList(const std::string& text)
+{
+  std::vector<std::string> results;
+  std::string item;
+  for(char c : text + ",")
+  {
+    if(c==',' || c==' ')
+    {
+      if(!item.empty())
+        results.push_back(item);
+      item.clear();
+    }
+    else
+      item += c;
+  }
+  return results;
+}
+
+//##################################################################################################
+//! Reads .ninja_log files (v5) and the logs written by time_command.sh, the last record of each
+//! output wins so that a log that has been appended to by incremental builds gives the most recent
+//! time of each command.
+bool readLog(const std::string& fileName, std::map<std::string, int64_t>& durations)
+{
+  std::ifstream in(fileName);
+  if(!in)
+    return false;
+
+  std::string line;
+  while(std::getline(in, line))
+  {
+    if(line.empty() || line.front()=='#')
+      continue;
+
+    std::istringstream ss(line);
+    std::string start;
+    std::string end;
+    std::string mtime;
+    std::string output;
+    if(!std::getline(ss, start, '\t') || !std::getline(ss, end, '\t') || !std::getline(ss, mtime, '\t') || !std::getline(ss, output, '\t'))
+      continue;
+
+    try
+    {
+      durations[output] = std::max<int64_t>(0, std::stoll(end) - std::stoll(start));
+    }
+    catch(...)
+    {
+    }
+  }
+  return true;
+}
+
+//##################################################################################################
+class Analysis_lt
+{
+public:
+  //################################################################################################
+  Analysis_lt(const Params_lt& params):
+    m_params(params)
+  {
+
+  }
+
+  //################################################################################################
+  bool load()
+  {
+    for(const auto& arg : m_params.modules)
+    {
+      // name:target:dependencies
+      auto a = arg.find(':');
+      auto b = (a==std::string::npos)?a:arg.find(':', a+1);
+      Module_lt module;
+      module.name = arg.substr(0, a);
+      module.target = (a==std::string::npos)?module.name:arg.substr(a+1, b-a-1);
+      if(b!=std::string::npos)
+        module.dependencies = splitList(arg.substr(b+1));
+      m_moduleIndexes[module.target] = m_modules.size();
+      m_moduleNames[module.name] = m_modules.size();
+      m_modules.push_back(module);
+    }
+
+    for(size_t m=0; m<m_modules.size(); m++)
+      addDependencies(m, m_modules.at(m).allDependencies);
+
+    std::map<std::string, int64_t> durations;
+    for(const auto& fileName : m_params.logFiles)
+    {
+      if(!readLog(fileName, durations))
+      {
+        std::cerr << "error: Failed to read: " << fileName << std::endl;
+        return false;
+      }
+    }
+
+    for(const auto& [output, duration] : durations)
+    {
+      std::string path = relativePath(output);
+      auto slash = path.find('/');
+
+      Task_lt task;
+      task.output = path;
+      task.duration = duration;
+
+      std::string first = path.substr(0, slash);
+      bool isArchive = (slash==std::string::npos && path.size()>2 && path.compare(path.size()-2, 2, ".a")==0);
+      if(isArchive)
+        first = path.substr(0, path.size()-2);
+
+      auto i = m_moduleIndexes.find(first);
+      if(i==m_moduleIndexes.end() || (slash==std::string::npos && !isArchive))
+      {
+        m_other.push_back(task);
+        continue;
+      }
+
+      task.module = i->second;
+      auto& module = m_modules.at(task.module);
+      if(isArchive || path == module.target + "/" + module.target)
+      {
+        module.finalTask = m_tasks.size();
+        module.isLib = isArchive;
+      }
+      module.tasks.push_back(m_tasks.size());
+      m_tasks.push_back(task);
+    }
+
+    if(m_tasks.empty())
+    {
+      std::cerr << "error: No build times found for any module, build with the times recorded first." << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+
+  //################################################################################################
+  void report()
+  {
+    int64_t total=0;
+    for(const auto& task : m_tasks)
+      total += task.duration;
+
+    std::cout << "Build times: " << m_tasks.size() << " commands, " << formatTime(total)
+              << " of work in " << m_modules.size() << " modules";
+    if(!m_other.empty())
+      std::cout << ", ignoring " << m_other.size() << " that are not part of a module";
+    std::cout << "\n";
+
+    reportModel("modules", "Each module starts once its dependencies are built (qmake, cmake Makefiles)", total);
+    reportModel("unified", "Objects of every module can build at once, links wait for libraries (gmake, ninja)", total);
+
+    std::vector<const Task_lt*> largest;
+    for(const auto& task : m_tasks)
+      largest.push_back(&task);
+    std::sort(largest.begin(), largest.end(), [](auto a, auto b){return a->duration > b->duration;});
+    largest.resize(std::min(largest.size(), m_params.top));
+
+    std::cout << "\nLargest commands:\n";
+    for(auto task : largest)
+      std::cout << "  " << std::setw(10) << formatTime(task->duration) << "  " << task->output << "\n";
+  }
+
+  //################################################################################################
+  bool writeTrace()
+  {
+    if(m_params.traceFile.empty())
+      return true;
+
+    buildGraph(m_params.traceModel);
+    size_t cores = m_params.traceCores;
+    if(cores==0)
+      cores = std::max(1u, std::thread::hardware_concurrency());
+
+    Schedule_lt schedule = simulate(cores);
+    auto path = criticalPath();
+    std::set<size_t> critical(path.begin(), path.end());
+
+    std::ofstream out(m_params.traceFile);
+    if(!out)
+    {
+      std::cerr << "error: Failed to write: " << m_params.traceFile << std::endl;
+      return false;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"" << m_params.traceModel << " build on " << cores << " cores\"}}";
+    for(size_t c=0; c<cores; c++)
+      out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << c << ",\"args\":{\"name\":\"core " << c << "\"}}";
+
+    for(size_t t=0; t<m_tasks.size(); t++)
+    {
+      const auto& task = m_tasks.at(t);
+      out << ",\n{\"name\":\"" << jsonEscape(task.output) << "\""
+          << ",\"cat\":\"" << jsonEscape(m_modules.at(task.module).name) << (critical.count(t)?",critical":"") << "\""
+          << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << schedule.core.at(t)
+          << ",\"ts\":" << schedule.start.at(t)*1000
+          << ",\"dur\":" << task.duration*1000
+          << ",\"args\":{\"module\":\"" << jsonEscape(m_modules.at(task.module).name) << "\",\"critical\":" << (critical.count(t)?"true":"false") << "}}";
+    }
+    out << "\n]}\n";
+
+    std::cout << "\nWrote a " << cores << " core " << m_params.traceModel << " build trace to: " << m_params.traceFile << "\n";
+    return true;
+  }
+
+private:
+  //################################################################################################
+  void addDependencies(size_t m, std::set<size_t>& results, size_t depth=0)
+  {
+    if(depth>m_modules.size())
+      return;
+
+    for(const auto& name : m_modules.at(m).dependencies)
+    {
+      auto i = m_moduleNames.find(name);
+      if(i==m_moduleNames.end() || i->second==m || !results.insert(i->second).second)
+        continue;
+      addDependencies(i->second, results, depth+1);
+    }
+  }
+
+  //################################################################################################
+  std::string relativePath(const std::string& output) const
+  {
+    auto path = std::filesystem::path(output).lexically_normal().generic_string();
+    if(!m_params.buildDir.empty())
+    {
+      auto buildDir = std::filesystem::path(m_params.buildDir).lexically_normal().generic_string();
+      if(!buildDir.empty() && buildDir.back()!='/')
+        buildDir += '/';
+      if(path.compare(0, buildDir.size(), buildDir)==0)
+        path = path.substr(buildDir.size());
+    }
+    if(path.compare(0, 2, "./")==0)
+      path = path.substr(2);
+    return path;
+  }
+
+  //################################################################################################
+  static std::string jsonEscape(const std::string& text)
+  {
+    std::string result;
+    for(char c : text)
+    {
+      if(c=='"' || c=='\\')
+        result += '\\';
+      result += c;
+    }
+    return result;
+  }
+
+  //################################################################################################
+  //! "modules" makes every task of a module wait for its dependencies to be built, "unified" only
+  //! makes links wait for the libraries they use and lets objects build at any time.
+  void buildGraph(const std::string& model)
+  {
+    for(auto& task : m_tasks)
+    {
+      task.dependencies.clear();
+      task.dependents.clear();
+    }
+
+    auto addEdge = [&](size_t from, size_t to)
+    {
+      m_tasks.at(to).dependencies.push_back(from);
+      m_tasks.at(from).dependents.push_back(to);
+    };
+
+    for(const auto& module : m_modules)
+    {
+      for(size_t t : module.tasks)
+      {
+        if(t==module.finalTask)
+          continue;
+        if(module.finalTask!=SIZE_MAX)
+          addEdge(t, module.finalTask);
+      }
+
+      for(size_t d : module.allDependencies)
+      {
+        size_t dependencyFinal = m_modules.at(d).finalTask;
+        if(dependencyFinal==SIZE_MAX)
+          continue;
+
+        if(model=="modules")
+        {
+          for(size_t t : module.tasks)
+            addEdge(dependencyFinal, t);
+        }
+        else if(!module.isLib && module.finalTask!=SIZE_MAX)
+          addEdge(dependencyFinal, module.finalTask);
+      }
+    }
+
+    // The longest path to the end of the build is known for every dependent of a task when the
+    // tasks are visited in reverse topological order.
+    auto order = topologicalOrder();
+    for(auto i=order.rbegin(); i!=order.rend(); ++i)
+    {
+      auto& task = m_tasks.at(*i);
+      int64_t longest=0;
+      for(size_t d : task.dependents)
+        longest = std::max(longest, m_tasks.at(d).bottomLevel);
+      task.bottomLevel = task.duration + longest;
+    }
+  }
+
+  //################################################################################################
+  std::vector<size_t> topologicalOrder() const
+  {
+    std::vector<size_t> order;
+    std::vector<size_t> remaining(m_tasks.size());
+    std::vector<size_t> ready;
+    for(size_t t=0; t<m_tasks.size(); t++)
+    {
+      remaining.at(t) = m_tasks.at(t).dependencies.size();
+      if(remaining.at(t)==0)
+        ready.push_back(t);
+    }
+
+    while(!ready.empty())
+    {
+      size_t t = ready.back();
+      ready.pop_back();
+      order.push_back(t);
+      for(size_t d : m_tasks.at(t).dependents)
+        if(--remaining.at(d)==0)
+          ready.push_back(d);
+    }
+
+    // A cycle in dependencies.pri leaves tasks out, they are added so that they are still counted.
+    if(order.size()!=m_tasks.size())
+      for(size_t t=0; t<m_tasks.size(); t++)
+        if(remaining.at(t)>0)
+          order.push_back(t);
+
+    return order;
+  }
+
+  //################################################################################################
+  //! The longest chain of tasks, which is the build time with unlimited cores.
+  std::vector<size_t> criticalPath() const
+  {
+    std::vector<size_t> path;
+    size_t t=SIZE_MAX;
+    for(size_t i=0; i<m_tasks.size(); i++)
+      if(m_tasks.at(i).dependencies.empty() && (t==SIZE_MAX || m_tasks.at(i).bottomLevel>m_tasks.at(t).bottomLevel))
+        t = i;
+
+    while(t!=SIZE_MAX && path.size()<=m_tasks.size())
+    {
+      path.push_back(t);
+      size_t next=SIZE_MAX;
+      for(size_t d : m_tasks.at(t).dependents)
+        if(next==SIZE_MAX || m_tasks.at(d).bottomLevel>m_tasks.at(next).bottomLevel)
+          next = d;
+      t = next;
+    }
+    return path;
+  }
+
+  //################################################################################################
+  //! List scheduling that always starts the ready task with the longest path to the end, this is
+  //! close to the best that a build tool can do with the given number of cores.
+  Schedule_lt simulate(size_t cores) const
+  {
+    Schedule_lt schedule;
+    schedule.start.resize(m_tasks.size(), 0);
+    schedule.core.resize(m_tasks.size(), 0);
+
+    std::vector<size_t> remaining(m_tasks.size());
+    auto byPriority = [&](size_t a, size_t b){return m_tasks.at(a).bottomLevel < m_tasks.at(b).bottomLevel;};
+    std::priority_queue<size_t, std::vector<size_t>, decltype(byPriority)> ready(byPriority);
+    for(size_t t=0; t<m_tasks.size(); t++)
+    {
+      remaining.at(t) = m_tasks.at(t).dependencies.size();
+      if(remaining.at(t)==0)
+        ready.push(t);
+    }
+
+    // Running tasks ordered by end time: (end, task, core).
+    using Running = std::tuple<int64_t, size_t, size_t>;
+    std::priority_queue<Running, std::vector<Running>, std::greater<Running>> running;
+    std::vector<size_t> freeCores;
+    for(size_t c=cores; c>0; c--)
+      freeCores.push_back(c-1);
+
+    int64_t now=0;
+    size_t done=0;
+    while(done<m_tasks.size())
+    {
+      while(!ready.empty() && !freeCores.empty())
+      {
+        size_t t = ready.top();
+        ready.pop();
+        size_t core = freeCores.back();
+        freeCores.pop_back();
+        schedule.start.at(t) = now;
+        schedule.core.at(t) = core;
+        running.emplace(now + m_tasks.at(t).duration, t, core);
+      }
+
+      if(running.empty())
+        break;
+
+      auto [end, t, core] = running.top();
+      running.pop();
+      now = end;
+      done++;
+      freeCores.push_back(core);
+      schedule.makespan = std::max(schedule.makespan, end);
+      for(size_t d : m_tasks.at(t).dependents)
+        if(--remaining.at(d)==0)
+          ready.push(d);
+    }
+
+    return schedule;
+  }
+
+  //################################################################################################
+  void reportModel(const std::string& model, const std::string& description, int64_t total)
+  {
+    buildGraph(model);
+    auto path = criticalPath();
+
+    int64_t pathTime=0;
+    for(size_t t : path)
+      pathTime += m_tasks.at(t).duration;
+
+    std::cout << "\n== " << model << ": " << description << "\n";
+    std::cout << "Critical path: " << formatTime(pathTime) << ", the most that more cores can speed this up is "
+              << std::fixed << std::setprecision(1) << double(total)/double(std::max<int64_t>(1, pathTime)) << "x\n\n";
+
+    std::cout << "  Cores        Time   Speedup  Efficiency\n";
+    for(size_t cores : m_params.cores)
+    {
+      int64_t makespan = std::max<int64_t>(1, simulate(cores).makespan);
+      double speedup = double(total)/double(makespan);
+      std::cout << "  " << std::setw(5) << cores
+                << "  " << std::setw(10) << formatTime(makespan)
+                << "  " << std::setw(7) << std::setprecision(1) << speedup << "x"
+                << "  " << std::setw(9) << std::setprecision(0) << 100.0*speedup/double(cores) << "%\n";
+    }
+
+    // Modules on the critical path, with the number of modules that have to wait for each one.
+    std::vector<size_t> order;
+    std::map<size_t, int64_t> moduleTime;
+    std::map<size_t, size_t> largestTask;
+    for(size_t t : path)
+    {
+      size_t m = m_tasks.at(t).module;
+      if(!moduleTime.count(m))
+        order.push_back(m);
+      moduleTime[m] += m_tasks.at(t).duration;
+      if(!largestTask.count(m) || m_tasks.at(t).duration > m_tasks.at(largestTask[m]).duration)
+        largestTask[m] = t;
+    }
+
+    std::cout << "\n  Modules that serialize the build, in critical path order:\n";
+    std::cout << "  " << std::left << std::setw(24) << "Module" << std::right << std::setw(12) << "On path" << std::setw(10) << "Waiting" << "  Largest step on the path\n";
+    for(size_t m : order)
+    {
+      size_t waiting=0;
+      for(const auto& other : m_modules)
+        waiting += other.allDependencies.count(m);
+
+      const auto& largest = m_tasks.at(largestTask[m]);
+      std::cout << "  " << std::left << std::setw(24) << m_modules.at(m).name << std::right
+                << std::setw(12) << formatTime(moduleTime[m])
+                << std::setw(10) << waiting
+                << "  " << largest.output << " (" << formatTime(largest.duration) << ")\n";
+    }
+  }
+
+  const Params_lt& m_params;
+  std::vector<Module_lt> m_modules;
+  std::map<std::string, size_t> m_moduleIndexes;
+  std::map<std::string, size_t> m_moduleNames;
+  std::vector<Task_lt> m_tasks;
+  std::vector<Task_lt> m_other;
+};
+
+//##################################################################################################
+void printUsage()
+{
+  std::cerr << "Usage: tpCriticalPath [options] <logs...>\n"
+               "  Finds the critical path of a full build from the time of each command in a\n"
+               "  .ninja_log or a log written by time_command.sh and the module dependency graph.\n"
+               "  --module=NAME:TARGET:DEP,DEP  A module, its target and the modules it depends on.\n"
+               "  --build-dir=DIR               Removed from the start of paths in the logs.\n"
+               "  --cores=1,2,4,...             Core counts to estimate the build time for.\n"
+               "  --trace=FILE                  Write a Chrome trace of the simulated build.\n"
+               "  --trace-model=unified|modules Build model for the trace, default: unified\n"
+               "  --trace-cores=N               Cores for the trace, defaults to the number of CPUs.\n"
+               "  --top=N                       Number of the largest commands to list.\n";
+}
+
+//##################################################################################################
+bool parseArgs(int argc, const char* argv[], Params_lt& params)
+{
+  try
+  {
+    for(int i=1; i<argc; i++)
+    {
+      std::string arg = argv[i];
+      if(arg.compare(0, 9, "--module=") == 0)
+        params.modules.push_back(arg.substr(9));
+      else if(arg.compare(0, 12, "--build-dir=") == 0)
+        params.buildDir = arg.substr(12);
+      else if(arg.compare(0, 8, "--cores=") == 0)
+      {
+        params.cores.clear();
+        for(const auto& c : splitList(arg.substr(8)))
+          params.cores.push_back(std::max<size_t>(1, size_t(std::stoul(c))));
+      }
+      else if(arg.compare(0, 8, "--trace=") == 0)
+        params.traceFile = arg.substr(8);
+      else if(arg.compare(0, 14, "--trace-model=") == 0)
+        params.traceModel = arg.substr(14);
+      else if(arg.compare(0, 14, "--trace-cores=") == 0)
+        params.traceCores = size_t(std::stoul(arg.substr(14)));
+      else if(arg.compare(0, 6, "--top=") == 0)
+        params.top = size_t(std::stoul(arg.substr(6)));
+      else if(arg.compare(0, 1, "-") == 0)
+        return false;
+      else
+        params.logFiles.push_back(arg);
+    }
+  }
+  catch(...)
+  {
+    return false;
+  }
+
+  return !params.logFiles.empty() && (params.traceModel=="unified" || params.traceModel=="modules");
+}
+}
+
+//##################################################################################################
+int main(int argc, const char* argv[])
+{
+  Params_lt params;
+  if(!parseArgs(argc, argv, params))
+  {
+    printUsage();
+    return 1;
+  }
+
+  Analysis_lt analysis(params);
+  if(!analysis.load())
+    return 1;
+
+  analysis.report();
+  return analysis.writeTrace()?0:1;
+}
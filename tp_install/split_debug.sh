@@ -0,0 +1,68 @@
+#!/bin/bash
+
+# Strips installed binaries and moves their debug info into separate compressed .debug files.
+#   split_debug.sh <debug directory> <files or directories...>
+#
+# Each ELF executable or shared library that has debug info is split into:
+#   <file>                                   - Stripped, with a .gnu_debuglink to the debug file.
+#   <debug directory>/.build-id/xx/yyyy.debug - The debug sections, zlib compressed.
+#
+# Point gdb at the debug directory with "set debug-file-directory" or install it to /usr/lib/debug.
+# Binaries without a build ID (link with -Wl,--build-id) use <debug directory>/<name>.debug.
+# Directories are not searched recursively, other files such as static libraries are left as they
+# are.
+
+set -e
+
+DEBUG_DIR=$1
+shift
+
+OBJCOPY=${OBJCOPY:-objcopy}
+READELF=${READELF:-readelf}
+
+split()
+{
+  local f=$1
+
+  # Only executables and shared libraries, not archives, objects or scripts.
+  local type=$(${READELF} -h "${f}" 2>/dev/null | sed -n 's/^ *Type: *\([A-Z]*\).*/\1/p')
+  if [ "${type}" != "EXEC" ] && [ "${type}" != "DYN" ]; then
+    return
+  fi
+
+  if ! ${READELF} -S "${f}" | grep -q '\.debug_info'; then
+    echo "warning: No debug info in ${f}, stripping without a .debug file." >&2
+    ${OBJCOPY} --strip-unneeded --remove-section=.comment "${f}"
+    return
+  fi
+
+  local id=$(${READELF} -n "${f}" 2>/dev/null | sed -n 's/^ *Build ID: *\([0-9a-f]*\).*/\1/p' | head -n 1)
+  local debug
+  if [ -n "${id}" ]; then
+    debug="${DEBUG_DIR}/.build-id/${id:0:2}/${id:2}.debug"
+  else
+    debug="${DEBUG_DIR}/$(basename "${f}").debug"
+  fi
+
+  mkdir -p "$(dirname "${debug}")"
+  ${OBJCOPY} --only-keep-debug --compress-debug-sections=zlib "${f}" "${debug}"
+  chmod -x "${debug}"
+
+  # The debug link has to be added after stripping, it holds a CRC of the debug file.
+  ${OBJCOPY} --strip-unneeded --remove-section=.comment "${f}"
+  ${OBJCOPY} --add-gnu-debuglink="${debug}" "${f}"
+
+  echo "${f} -> ${debug}"
+}
+
+for path in "$@"; do
+  if [ -d "${path}" ]; then
+    for f in "${path}"/*; do
+      if [ -f "${f}" ] && [ ! -L "${f}" ]; then
+        split "${f}"
+      fi
+    done
+  elif [ -f "${path}" ]; then
+    split "${path}"
+  fi
+done
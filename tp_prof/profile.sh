@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# Records a profile of a program using perf and renders it as a flame graph.
+#   profile.sh <tpFlameGraph> <output directory> <program> [arguments...]
+#
+# Build with tp_prof so that the call stacks can be walked using the frame pointers.
+#   TP_PROF_FREQUENCY  - Samples per second, default: 999
+#   TP_PROF_CALL_GRAPH - Unwinding method passed to perf record --call-graph, default: fp
+
+set -e
+
+TP_FLAMEGRAPH=$1
+OUTPUT_DIR=$2
+shift
+shift
+
+if ! which perf > /dev/null 2>&1; then
+  echo "error: perf not found, install the perf package for your kernel." >&2
+  exit 1
+fi
+
+mkdir -p "${OUTPUT_DIR}"
+
+perf record -F ${TP_PROF_FREQUENCY:-999} --call-graph=${TP_PROF_CALL_GRAPH:-fp} -o "${OUTPUT_DIR}/perf.data" -- "$@"
+perf script -i "${OUTPUT_DIR}/perf.data" > "${OUTPUT_DIR}/perf.script"
+"${TP_FLAMEGRAPH}" "${OUTPUT_DIR}/flamegraph.svg" "${OUTPUT_DIR}/perf.script" "$(basename "$1")"
@@ -0,0 +1,241 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+namespace
+{
+
+//##################################################################################################
+struct Node_lt
+{
+  std::string name;
+  size_t value{0};
+  std::map<std::string, Node_lt> children;
+};
+
+//##################################################################################################
+std::string escapeXML(const std::string& text)
+{
+  std::string result;
+  for(char c : text)
+  {
+    switch(c)
+    {
+    case '&': result += "&amp;"; break;
+    case '<': result += "&lt;";  break;
+    case '>': result += "&gt;";  break;
+    case '"': result += "&quot;"; break;
+    default:  result += c;
+    }
+  }
+  return result;
+}
+
+//##################################################################################################
+//! Turn a perf script frame line "addr symbol+0x12 (dso)" into "symbol".
+std::string frameName(const std::string& line)
+{
+  std::stringstream ss(line);
+  std::string address;
+  ss >> address;
+
+  std::string rest;
+  std::getline(ss, rest);
+
+  auto dso = rest.rfind(" (");
+  if(dso != std::string::npos)
+    rest = rest.substr(0, dso);
+
+  auto start = rest.find_first_not_of(' ');
+  if(start == std::string::npos)
+    return "[unknown]";
+  rest = rest.substr(start);
+
+  auto offset = rest.rfind("+0x");
+  if(offset != std::string::npos)
+    rest = rest.substr(0, offset);
+
+  return rest.empty()?"[unknown]":rest;
+}
+
+//##################################################################################################
+//! Collapse the output of "perf script" into a tree of stacks, the root is the process name.
+void collapse(std::istream& in, Node_lt& root)
+{
+  std::string comm;
+  std::vector<std::string> frames;
+
+  auto flush = [&]
+  {
+    if(comm.empty())
+      return;
+
+    Node_lt* node = &root;
+    node->value++;
+
+    node = &node->children[comm];
+    node->name = comm;
+    node->value++;
+
+    for(auto i=frames.rbegin(); i!=frames.rend(); ++i)
+    {
+      node = &node->children[*i];
+      node->name = *i;
+      node->value++;
+    }
+
+    comm.clear();
+    frames.clear();
+  };
+
+  std::string line;
+  while(std::getline(in, line))
+  {
+    if(line.empty())
+    {
+      flush();
+      continue;
+    }
+
+    if(line.front() == '#')
+      continue;
+
+    if(line.front() != ' ' && line.front() != '\t')
+    {
+      flush();
+      std::stringstream ss(line);
+      ss >> comm;
+      continue;
+    }
+
+    frames.push_back(frameName(line));
+  }
+
+  flush();
+}
+
+//##################################################################################################
+std::string color(const std::string& name)
+{
+  uint32_t hash=2166136261u;
+  for(char c : name)
+    hash = (hash ^ uint8_t(c)) * 16777619u;
+
+  int r = 205 + int(hash%50);
+  int g = int((hash>>8)%230);
+  int b = int((hash>>16)%55);
+  return "rgb(" + std::to_string(r) + "," + std::to_string(g) + "," + std::to_string(b) + ")";
+}
+
+//##################################################################################################
+size_t depth(const Node_lt& node)
+{
+  size_t d=0;
+  for(const auto& child : node.children)
+    d = std::max(d, depth(child.second));
+  return d+1;
+}
+
+//##################################################################################################
+void writeSVG(const Node_lt& root, const std::string& title, std::ostream& out)
+{
+  const double width = 1200.0;
+  const double frameHeight = 16.0;
+  const double pad = 10.0;
+  const double top = 30.0;
+  const double usable = width - 2.0*pad;
+
+  size_t levels = depth(root);
+  double height = top + double(levels)*frameHeight + pad;
+  double scale = (root.value>0)?(usable/double(root.value)):0.0;
+
+  out << "<?xml version=\"1.0\" standalone=\"no\"?>\n";
+  out << "<svg version=\"1.1\" width=\"" << width << "\" height=\"" << height << "\" "
+      << "xmlns=\"http://www.w3.org/2000/svg\" font-family=\"Verdana\" font-size=\"12\">\n";
+  out << "<rect x=\"0\" y=\"0\" width=\"100%\" height=\"100%\" fill=\"#f8f8f8\"/>\n";
+  out << "<text x=\"" << width/2.0 << "\" y=\"20\" text-anchor=\"middle\" font-size=\"16\">" << escapeXML(title) << "</text>\n";
+
+  std::function<void(const Node_lt&, double, size_t)> draw = [&](const Node_lt& node, double x, size_t level)
+  {
+    double w = double(node.value)*scale;
+    if(w<0.1)
+      return;
+
+    double y = height - pad - double(level+1)*frameHeight;
+    std::string name = level?node.name:"all";
+    double percent = (root.value>0)?(100.0*double(node.value)/double(root.value)):0.0;
+
+    out << "<g><title>" << escapeXML(name) << " (" << node.value << " samples, " << percent << "%)</title>"
+        << "<rect x=\"" << x << "\" y=\"" << y << "\" width=\"" << w << "\" height=\"" << frameHeight-1.0 << "\" "
+        << "fill=\"" << color(name) << "\" rx=\"2\" ry=\"2\"/>";
+
+    // Roughly 7 pixels per character at this font size.
+    size_t chars = size_t(w/7.0);
+    if(chars>=3)
+    {
+      std::string label = (name.size()<=chars)?name:(name.substr(0, chars-2) + "..");
+      out << "<text x=\"" << x+3.0 << "\" y=\"" << y+frameHeight-4.0 << "\">" << escapeXML(label) << "</text>";
+    }
+    out << "</g>\n";
+
+    // Like the original flame graph, frames are sorted by name within a level.
+    double childX = x;
+    for(const auto& child : node.children)
+    {
+      draw(child.second, childX, level+1);
+      childX += double(child.second.value)*scale;
+    }
+  };
+
+  draw(root, pad, 0);
+  out << "</svg>\n";
+}
+}
+
+//##################################################################################################
+int main(int argc, const char* argv[])
+{
+  if(argc<2 || argc>4)
+  {
+    std::cerr << "Usage: tpFlameGraph <flamegraph.svg> [perf.script] [title]\n"
+                 "  Renders the output of \"perf script\" as a flame graph, reads stdin if no input is given." << std::endl;
+    return 1;
+  }
+
+  Node_lt root;
+  if(argc>=3)
+  {
+    std::ifstream in(argv[2]);
+    if(!in)
+    {
+      std::cerr << "error: Failed to read: " << argv[2] << std::endl;
+      return 1;
+    }
+    collapse(in, root);
+  }
+  else
+    collapse(std::cin, root);
+
+  if(root.value==0)
+  {
+    std::cerr << "error: No samples found." << std::endl;
+    return 1;
+  }
+
+  std::ofstream out(argv[1]);
+  if(!out)
+  {
+    std::cerr << "error: Failed to write: " << argv[1] << std::endl;
+    return 1;
+  }
+
+  writeSVG(root, (argc>=4)?argv[3]:"Flame Graph", out);
+  std::cout << "Flame graph of " << root.value << " samples written to: " << argv[1] << std::endl;
+  return 0;
+}
@@ -112,7 +112,7 @@ int main(int argc, const char * argv[])
     }
 
 #if 0
-    cppText += "const char* data" + std::to_string(c) + " = \"";
+    cppText += "const char* tp_rc_data" + std::to_string(c) + " = \"";
 
     const char digits[] = "0123456789ABCDEF";
     for(size_t i=0; i<fileData.size(); i++)
@@ -123,7 +123,7 @@ int main(int argc, const char * argv[])
 
     cppText += "\";\n";
 #else
-    cppText += "const uint8_t data" + std::to_string(c) + "[] = {";
+    cppText += "const uint8_t tp_rc_data" + std::to_string(c) + "[] = {";
 
     for(size_t i=0; i<fileData.size(); i++)
     {
@@ -135,8 +135,8 @@ int main(int argc, const char * argv[])
     cppText += "0};\n";
 #endif
 
-    cppText += "size_t size" + std::to_string(c) + "=" + std::to_string(fileData.size()) + ";\n\n";
-    initText += "  tp_utils::addResource(\"" + prefix + alias + "\",reinterpret_cast<const char*>(data" + std::to_string(c) + "),size" + std::to_string(c) + ");\n";
+    cppText += "size_t tp_rc_size" + std::to_string(c) + "=" + std::to_string(fileData.size()) + ";\n\n";
+    initText += "  tp_utils::addResource(\"" + prefix + alias + "\",reinterpret_cast<const char*>(tp_rc_data" + std::to_string(c) + "),tp_rc_size" + std::to_string(c) + ");\n";
     c++;
 
     depText += inputFilePath + '\n';
@@ -0,0 +1,927 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <iomanip>
+#include <filesystem>
+#include <cstdint>
+#include <cstdlib>
+#include <cctype>
+
+namespace
+{
+
+//##################################################################################################
+struct Module_lt
+{
+  size_t total{0};
+  size_t rc{0}; //!< Bytes of embedded tp_rc resources, included in total.
+  size_t flash{0};
+  size_t ram{0};
+  std::map<std::string, size_t> sections;
+};
+
+//##################################################################################################
+//! Sizes attributed to modules, sections and symbols, either read from link maps or a saved report.
+struct Report_lt
+{
+  std::map<std::string, size_t> sections;
+  std::map<std::string, Module_lt> modules;
+  std::map<std::pair<std::string, std::string>, size_t> symbols; //!< (module, symbol) -> bytes
+  std::map<std::string, size_t> files;
+  size_t total{0};
+  size_t flash{0};
+  size_t ram{0};
+};
+
+//##################################################################################################
+struct Params_lt
+{
+  std::vector<std::string> maps;
+  std::vector<std::string> files;
+  std::string buildDirectory;
+  std::string baseline;
+  std::string save;
+  std::vector<std::pair<std::string, size_t>> budgets;
+  std::vector<std::pair<std::string, size_t>> flashBudgets;
+  std::vector<std::pair<std::string, size_t>> ramBudgets;
+  size_t symbols{20};
+  bool memory{false};
+};
+
+//##################################################################################################
+bool startsWith(const std::string& text, const std::string& prefix)
+{
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+//##################################################################################################
+std::vector<std::string> split(const std::string& line)
+{
+  std::vector<std::string> tokens;
+  std::stringstream ss(line);
+  std::string token;
+  while(ss >> token)
+    tokens.push_back(token);
+  return tokens;
+}
+
+//##################################################################################################
+//! Sections that are not loaded onto the device or downloaded by the browser.
+bool ignoredSection(const std::string& section)
+{
+  for(const char* prefix : {".debug", ".comment", ".note", ".stab", ".gnu.attributes", ".ARM.attributes", "/DISCARD/", "reloc.", ".zdebug"})
+    if(startsWith(section, prefix))
+      return true;
+  return false;
+}
+
+//##################################################################################################
+//! Sections that the linker creates, GNU ld lists the first input file against these.
+bool linkerSection(const std::string& section)
+{
+  for(const char* name : {".interp", ".dynamic", ".dynsym", ".dynstr", ".hash", ".gnu.hash", ".gnu.version", ".gnu.version_r", ".got", ".got.plt", ".plt", ".plt.got", ".plt.sec", ".rela.dyn", ".rela.plt", ".rel.dyn", ".rel.plt", ".eh_frame_hdr"})
+    if(section == name)
+      return true;
+  return false;
+}
+
+//##################################################################################################
+//! Where a section lives on a microcontroller, initialized data is stored in flash and copied to RAM.
+void memoryType(const std::string& section, bool& flash, bool& ram)
+{
+  std::string lower = section;
+  std::transform(lower.begin(), lower.end(), lower.begin(), [](char c){return char(std::tolower(c));});
+
+  flash = false;
+  ram = false;
+
+  for(const char* prefix : {".eeprom", ".fuse", ".lock", ".signature"})
+    if(startsWith(lower, prefix))
+      return;
+
+  for(const char* prefix : {".data", ".sdata", ".tdata", ".ramfunc"})
+  {
+    if(startsWith(lower, prefix))
+    {
+      flash = true;
+      ram = true;
+      return;
+    }
+  }
+
+  // GNU sections and the SDCC areas that hold variables.
+  for(const char* prefix : {".bss", ".sbss", ".tbss", ".noinit", "common"})
+    if(startsWith(lower, prefix))
+      ram = true;
+  for(const char* name : {"heap", "stack"})
+    if(lower.find(name) != std::string::npos)
+      ram = true;
+  for(const char* name : {"DSEG", "OSEG", "ISEG", "BSEG", "XSEG", "PSEG", "XISEG", "IABS", "XABS", "DABS", "BABS", "SSEG", "IDATA", "DATA", "_DATA", "INITIALIZED", "BSS"})
+    if(section == name)
+      ram = true;
+  if(startsWith(section, "REG_BANK_"))
+    ram = true;
+
+  flash = !ram;
+}
+
+//##################################################################################################
+//! Sizes like 64K or 1M.
+bool parseSize(const std::string& text, size_t& size)
+{
+  try
+  {
+    size_t end=0;
+    size = std::stoull(text, &end, 0);
+    std::string suffix = text.substr(end);
+    if(suffix == "K" || suffix == "k")
+      size *= 1024;
+    else if(suffix == "M" || suffix == "m")
+      size *= 1024*1024;
+    else if(!suffix.empty())
+      return false;
+    return true;
+  }
+  catch(...)
+  {
+    return false;
+  }
+}
+
+//##################################################################################################
+class MapParser_lt
+{
+public:
+  //################################################################################################
+  MapParser_lt(const std::string& buildDirectory, Report_lt& report):
+    m_report(report)
+  {
+    std::error_code ec;
+    if(!buildDirectory.empty())
+      m_buildDirectory = std::filesystem::weakly_canonical(buildDirectory, ec);
+  }
+
+  //################################################################################################
+  bool parse(const std::string& fileName)
+  {
+    std::ifstream in(fileName);
+    if(!in)
+    {
+      std::cerr << "error: Failed to read map file: " << fileName << std::endl;
+      return false;
+    }
+
+    std::vector<std::string> lines;
+    for(std::string line; std::getline(in, line);)
+    {
+      if(!line.empty() && line.back() == '\r')
+        line.pop_back();
+      lines.push_back(line);
+    }
+
+    // lld (ELF and wasm) starts with a column header, GNU ld writes a linker script like listing and
+    // the SDCC linker lists the areas with the symbols in each.
+    for(size_t i=0; i<lines.size() && i<4; i++)
+      if(lines.at(i).find(" Out ") != std::string::npos && lines.at(i).find(" In ") != std::string::npos)
+        return parseLLD(lines, i);
+
+    for(const auto& line : lines)
+      if(startsWith(line, "Area ") && line.find("Decimal Bytes") != std::string::npos)
+        return parseSDCC(lines);
+
+    return parseGNU(lines);
+  }
+
+private:
+  //################################################################################################
+  //! The module is the first directory in the build directory, or the name of an archive in it.
+  std::string moduleName(const std::string& input, bool& rc) const
+  {
+    std::string path = input;
+    std::string member;
+    if(auto open = input.find('('); open != std::string::npos && input.back() == ')')
+    {
+      path = input.substr(0, open);
+      member = input.substr(open+1, input.size()-open-2);
+    }
+
+    rc = (member.find(".qrc.cpp.") != std::string::npos || path.find(".qrc.cpp.") != std::string::npos);
+
+    if(path.empty() || path.front() == '<' || path == "linker stubs")
+      return "[linker]";
+
+    std::error_code ec;
+    std::filesystem::path p = std::filesystem::weakly_canonical(path, ec);
+    if(!m_buildDirectory.empty())
+    {
+      auto relative = p.lexically_relative(m_buildDirectory);
+      if(!relative.empty() && *relative.begin() != "..")
+      {
+        if(std::distance(relative.begin(), relative.end())>1)
+          return relative.begin()->string();
+        return relative.stem().string();
+      }
+    }
+
+    // Link time optimization compiles the whole program into partitions that don't map to modules.
+    if(p.filename().string().find(".ltrans") != std::string::npos)
+      return "[lto]";
+
+    return "[" + p.filename().string() + "]";
+  }
+
+  //################################################################################################
+  void add(const std::string& input, const std::string& inputSection, size_t size)
+  {
+    if(size==0 || ignoredSection(m_section))
+      return;
+
+    bool rc=false;
+    m_module = linkerSection(m_section)?"[linker]":moduleName(input, rc);
+    m_rc = rc || inputSection.find("tp_rc_data") != std::string::npos;
+
+    Module_lt& module = m_report.modules[m_module];
+    module.total += size;
+    module.sections[m_section] += size;
+    if(m_rc)
+      module.rc += size;
+    m_report.sections[m_section] += size;
+    m_report.total += size;
+    m_sectionAttributed += size;
+
+    bool flash=false;
+    bool ram=false;
+    memoryType(m_section, flash, ram);
+    if(flash)
+    {
+      module.flash += size;
+      m_report.flash += size;
+    }
+    if(ram)
+    {
+      module.ram += size;
+      m_report.ram += size;
+    }
+  }
+
+  //################################################################################################
+  //! Start a new output section, anything the inputs of the last one didn't cover came from the
+  //! linker, for example alignment padding or the wasm type and import sections.
+  void startSection(const std::string& section, size_t size)
+  {
+    if(m_sectionSize>m_sectionAttributed)
+      add("<internal>", std::string(), m_sectionSize-m_sectionAttributed);
+
+    m_section = section;
+    m_sectionSize = size;
+    m_sectionAttributed = 0;
+    m_module.clear();
+  }
+
+  //################################################################################################
+  void addSymbol(const std::string& symbol, size_t size)
+  {
+    if(size==0 || m_module.empty() || ignoredSection(m_section))
+      return;
+
+    m_report.symbols[{m_module, symbol}] += size;
+    if(!m_rc && symbol.find("tp_rc_data") != std::string::npos)
+    {
+      Module_lt& module = m_report.modules[m_module];
+      module.rc += std::min(size, module.total-module.rc);
+    }
+  }
+
+  //################################################################################################
+  //! GNU ld does not list the sizes of symbols, they run to the next symbol or the end of the input.
+  void flushSymbols()
+  {
+    std::stable_sort(m_symbols.begin(), m_symbols.end(), [](const auto& a, const auto& b)
+    {
+      return a.first<b.first;
+    });
+
+    for(size_t i=0; i<m_symbols.size(); i++)
+    {
+      size_t end = (i+1<m_symbols.size())?m_symbols.at(i+1).first:m_inputEnd;
+      size_t address = m_symbols.at(i).first;
+      if(end>address)
+        addSymbol(m_symbols.at(i).second, end-address);
+    }
+
+    m_symbols.clear();
+    m_module.clear();
+  }
+
+  //################################################################################################
+  bool parseGNU(const std::vector<std::string>& lines)
+  {
+    bool started=false;
+    std::string pendingOutput;
+    std::string pendingInput;
+
+    auto isHex = [](const std::string& token){return startsWith(token, "0x");};
+
+    for(const auto& line : lines)
+    {
+      if(!started)
+      {
+        started = startsWith(line, "Linker script and memory map");
+        continue;
+      }
+
+      auto tokens = split(line);
+      if(tokens.empty())
+        continue;
+
+      // Output section, long names put the address and size on the next line.
+      if(line.front() != ' ')
+      {
+        flushSymbols();
+        if(tokens.size()==1)
+          pendingOutput = tokens.front();
+        else if(tokens.size()>=3 && isHex(tokens.at(1)) && isHex(tokens.at(2)))
+          startSection(tokens.front(), std::stoull(tokens.at(2), nullptr, 16));
+        continue;
+      }
+
+      if(!pendingOutput.empty())
+      {
+        if(tokens.size()>=2 && isHex(tokens.at(0)) && isHex(tokens.at(1)))
+          startSection(pendingOutput, std::stoull(tokens.at(1), nullptr, 16));
+        pendingOutput.clear();
+        continue;
+      }
+
+      if(!pendingInput.empty())
+      {
+        tokens.insert(tokens.begin(), pendingInput);
+        pendingInput.clear();
+      }
+      else if(line.size()>1 && line.at(1) != ' ')
+      {
+        if(tokens.size()==1 && tokens.front().find('(') == std::string::npos)
+        {
+          pendingInput = tokens.front();
+          continue;
+        }
+      }
+      else if(tokens.size()>=2 && isHex(tokens.at(0)) && !isHex(tokens.at(1)))
+      {
+        // Symbol, the demangled name can contain spaces.
+        std::string name = line.substr(line.find(tokens.at(1), line.find(tokens.at(0))+tokens.at(0).size()));
+        if(!startsWith(name, "PROVIDE") && !startsWith(name, ".") && !startsWith(name, "(size before relaxing)") && name.find(" = ") == std::string::npos)
+          m_symbols.emplace_back(std::stoull(tokens.at(0), nullptr, 16), name);
+        continue;
+      }
+      else
+        continue;
+
+      // Input section: name address size [file]
+      if(tokens.size()<3 || !isHex(tokens.at(1)) || !isHex(tokens.at(2)))
+        continue;
+
+      flushSymbols();
+      size_t address = std::stoull(tokens.at(1), nullptr, 16);
+      size_t size = std::stoull(tokens.at(2), nullptr, 16);
+      m_inputEnd = address+size;
+
+      std::string file;
+      if(tokens.size()>3)
+        file = line.substr(line.find(tokens.at(3), line.find(tokens.at(2))+tokens.at(2).size()));
+      if(tokens.front() == "*fill*")
+        file.clear();
+      add(file, tokens.front(), size);
+    }
+
+    flushSymbols();
+    startSection(std::string(), 0);
+    return started;
+  }
+
+  //################################################################################################
+  bool parseLLD(const std::vector<std::string>& lines, size_t headerLine)
+  {
+    const std::string& header = lines.at(headerLine);
+    size_t outColumn = header.find(" Out ")+1;
+    size_t inColumn = header.find(" In ")+1;
+
+    size_t sizeToken=0;
+    for(const auto& token : split(header.substr(0, outColumn)))
+    {
+      if(token == "Size")
+        break;
+      sizeToken++;
+    }
+
+    for(size_t i=headerLine+1; i<lines.size(); i++)
+    {
+      const std::string& line = lines.at(i);
+      if(line.size()<=outColumn)
+        continue;
+
+      auto fields = split(line.substr(0, outColumn));
+      if(fields.size()<=sizeToken)
+        continue;
+
+      size_t size=0;
+      try
+      {
+        size = std::stoull(fields.at(sizeToken), nullptr, 16);
+      }
+      catch(...)
+      {
+        continue;
+      }
+
+      size_t nameColumn = line.find_first_not_of(' ', outColumn);
+      if(nameColumn == std::string::npos)
+        continue;
+      std::string name = line.substr(nameColumn);
+
+      if(nameColumn == outColumn)
+        startSection(name, size);
+      else if(nameColumn == inColumn)
+      {
+        // file:(section) or archive(member):(section), wasm lists each function as its own input.
+        std::string file = name;
+        std::string inputSection;
+        if(auto colon = name.rfind(":("); colon != std::string::npos)
+        {
+          file = name.substr(0, colon);
+          inputSection = name.substr(colon+2, name.size()-colon-3);
+        }
+        add(file, inputSection, size);
+        if(size==0)
+          m_module.clear();
+      }
+      else
+        addSymbol(name, size);
+    }
+
+    startSection(std::string(), 0);
+    return true;
+  }
+
+  //################################################################################################
+  //! SDCC only lists global symbols, the size of each is up to the next symbol in the area so static
+  //! functions and variables are counted with the global before them.
+  bool parseSDCC(const std::vector<std::string>& lines)
+  {
+    auto isHex = [](const std::string& token)
+    {
+      return !token.empty() && token.find_first_not_of("0123456789abcdefABCDEF") == std::string::npos;
+    };
+
+    auto clean = [](std::string name)
+    {
+      name.erase(std::remove_if(name.begin(), name.end(), [](char c){return c=='[' || c==']' || c==',';}), name.end());
+      if(auto dot = name.rfind(".rel"); dot != std::string::npos && dot+4 == name.size())
+        name = name.substr(0, dot);
+      return name;
+    };
+
+    // The SDCC module names are the source file names, the files they came from are listed at the end.
+    std::map<std::string, std::string> modulePaths;
+    bool files=false;
+    for(const auto& line : lines)
+    {
+      if(startsWith(line, "Files Linked") || startsWith(line, "Libraries Linked"))
+      {
+        files = true;
+        continue;
+      }
+
+      auto tokens = split(line);
+      if(!files || tokens.size()<2 || startsWith(line, "User Base"))
+      {
+        files = files && tokens.empty();
+        continue;
+      }
+
+      for(size_t t=1; t<tokens.size(); t++)
+        if(auto name = clean(tokens.at(t)); !name.empty())
+          modulePaths[name] = tokens.front();
+    }
+
+    struct Symbol_lt
+    {
+      size_t address{0};
+      std::string name;
+      std::string module;
+    };
+
+    size_t areaAddress=0;
+    size_t areaSize=0;
+    std::vector<Symbol_lt> symbols;
+
+    auto flushArea = [&]
+    {
+      std::stable_sort(symbols.begin(), symbols.end(), [](const auto& a, const auto& b)
+      {
+        return a.address<b.address;
+      });
+
+      for(size_t i=0; i<symbols.size(); i++)
+      {
+        const auto& symbol = symbols.at(i);
+        size_t end = (i+1<symbols.size())?symbols.at(i+1).address:areaAddress+areaSize;
+        if(symbol.address<areaAddress || end<=symbol.address || end>areaAddress+areaSize)
+          continue;
+
+        auto path = modulePaths.find(symbol.module);
+        add((path!=modulePaths.end())?path->second:symbol.module, std::string(), end-symbol.address);
+        addSymbol(symbol.name, end-symbol.address);
+      }
+
+      symbols.clear();
+    };
+
+    bool started=false;
+    for(const auto& line : lines)
+    {
+      if(startsWith(line, "Files Linked"))
+        break;
+
+      auto tokens = split(line);
+
+      // NAME ADDR SIZE = DECIMAL. bytes (ATTRIBUTES)
+      if(tokens.size()>=6 && tokens.at(3) == "=" && tokens.at(5) == "bytes" && isHex(tokens.at(1)) && isHex(tokens.at(2)))
+      {
+        flushArea();
+        areaAddress = std::stoull(tokens.at(1), nullptr, 16);
+        areaSize = std::stoull(tokens.at(2), nullptr, 16);
+        startSection(tokens.at(0), areaSize);
+        started = true;
+        continue;
+      }
+
+      // Some ports prefix the value with the address space, for example "C:".
+      if(!tokens.empty() && tokens.front().size()>1 && tokens.front().back() == ':')
+        tokens.erase(tokens.begin());
+
+      if(started && tokens.size()>=2 && isHex(tokens.at(0)))
+      {
+        Symbol_lt& symbol = symbols.emplace_back();
+        symbol.address = std::stoull(tokens.at(0), nullptr, 16);
+        symbol.name = tokens.at(1);
+        if(tokens.size()>=3)
+          symbol.module = tokens.at(2);
+      }
+    }
+
+    flushArea();
+    startSection(std::string(), 0);
+    return started;
+  }
+
+  Report_lt& m_report;
+  std::filesystem::path m_buildDirectory;
+  std::string m_section;
+  size_t m_sectionSize{0};
+  size_t m_sectionAttributed{0};
+  std::string m_module;
+  bool m_rc{false};
+  size_t m_inputEnd{0};
+  std::vector<std::pair<size_t, std::string>> m_symbols;
+};
+
+//##################################################################################################
+//! A tab separated report that can be stored as a baseline.
+bool saveReport(const std::string& fileName, const Report_lt& report)
+{
+  std::error_code ec;
+  if(auto parent = std::filesystem::path(fileName).parent_path(); !parent.empty())
+    std::filesystem::create_directories(parent, ec);
+
+  std::ofstream out(fileName);
+  if(!out)
+  {
+    std::cerr << "error: Failed to write: " << fileName << std::endl;
+    return false;
+  }
+
+  out << "# tpSize\n";
+  for(const auto& [name, size] : report.sections)
+    out << "section\t" << name << '\t' << size << '\n';
+  for(const auto& [name, module] : report.modules)
+    out << "module\t" << name << '\t' << module.total << '\t' << module.rc << '\t' << module.flash << '\t' << module.ram << '\n';
+  for(const auto& [name, size] : report.files)
+    out << "file\t" << name << '\t' << size << '\n';
+  for(const auto& [key, size] : report.symbols)
+    out << "symbol\t" << key.first << '\t' << size << '\t' << key.second << '\n';
+  return true;
+}
+
+//##################################################################################################
+bool loadReport(const std::string& fileName, Report_lt& report)
+{
+  std::ifstream in(fileName);
+  if(!in)
+    return false;
+
+  for(std::string line; std::getline(in, line);)
+  {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    for(std::string field; std::getline(ss, field, '\t');)
+      fields.push_back(field);
+
+    try
+    {
+      if(fields.size()==3 && fields.at(0) == "section")
+        report.sections[fields.at(1)] = std::stoull(fields.at(2));
+      else if(fields.size()>=4 && fields.at(0) == "module")
+      {
+        Module_lt& module = report.modules[fields.at(1)];
+        module.total = std::stoull(fields.at(2));
+        module.rc = std::stoull(fields.at(3));
+        if(fields.size()>=6)
+        {
+          module.flash = std::stoull(fields.at(4));
+          module.ram = std::stoull(fields.at(5));
+        }
+        report.total += module.total;
+        report.flash += module.flash;
+        report.ram += module.ram;
+      }
+      else if(fields.size()==3 && fields.at(0) == "file")
+        report.files[fields.at(1)] = std::stoull(fields.at(2));
+      else if(fields.size()==4 && fields.at(0) == "symbol")
+        report.symbols[{fields.at(1), fields.at(3)}] = std::stoull(fields.at(2));
+    }
+    catch(...)
+    {
+      std::cerr << "warning: Ignoring invalid line in " << fileName << ": " << line << std::endl;
+    }
+  }
+
+  return true;
+}
+
+//##################################################################################################
+std::string formatChange(bool hasBaseline, size_t baseline, size_t current)
+{
+  if(!hasBaseline)
+    return "new";
+
+  std::stringstream ss;
+  ss << std::showpos << (int64_t(current)-int64_t(baseline));
+  if(baseline>0)
+    ss << " (" << std::fixed << std::setprecision(1) << (double(current)-double(baseline))/double(baseline)*100.0 << "%)";
+  return ss.str();
+}
+
+//##################################################################################################
+void printUsage()
+{
+  std::cerr << "Usage: tpSize [options] <map files...>\n"
+               "  Attributes the bytes of a linked binary or wasm to modules, sections and symbols\n"
+               "  using the link map, including the tp_rc resources embedded in each module.\n"
+               "  --build-dir=DIR        Inputs in DIR are attributed to the module they were built for.\n"
+               "  --file=PATH            Also report the size on disk of PATH, for example the stripped\n"
+               "                         binary or the wasm after wasm-opt.\n"
+               "  --baseline=FILE        Show the changes since a report saved with --save.\n"
+               "  --save=FILE            Save the report so that it can be used as a baseline.\n"
+               "  --budget=MODULE:SIZE   Fail if MODULE is larger than SIZE bytes (K and M suffixes),\n"
+               "                         use \"total\" for the whole binary.\n"
+               "  --memory               Show the flash and RAM used by each module, for microcontrollers.\n"
+               "  --flash-budget=MODULE:SIZE\n"
+               "  --ram-budget=MODULE:SIZE\n"
+               "                         Fail if MODULE uses more flash or RAM than SIZE, implies --memory.\n"
+               "  --symbols=N            Number of symbols to list, default: 20\n";
+}
+
+//##################################################################################################
+bool parseArgs(int argc, const char* argv[], Params_lt& params)
+{
+  try
+  {
+    for(int i=1; i<argc; i++)
+    {
+      std::string arg = argv[i];
+      if(startsWith(arg, "--build-dir="))
+        params.buildDirectory = arg.substr(12);
+      else if(startsWith(arg, "--file="))
+        params.files.push_back(arg.substr(7));
+      else if(startsWith(arg, "--baseline="))
+        params.baseline = arg.substr(11);
+      else if(startsWith(arg, "--save="))
+        params.save = arg.substr(7);
+      else if(startsWith(arg, "--symbols="))
+        params.symbols = std::stoull(arg.substr(10));
+      else if(arg == "--memory")
+        params.memory = true;
+      else if(startsWith(arg, "--budget=") || startsWith(arg, "--flash-budget=") || startsWith(arg, "--ram-budget="))
+      {
+        auto equals = arg.find('=');
+        std::string budget = arg.substr(equals+1);
+        auto colon = budget.rfind(':');
+        size_t size=0;
+        if(colon == std::string::npos || !parseSize(budget.substr(colon+1), size))
+          return false;
+
+        auto& budgets = startsWith(arg, "--flash")?params.flashBudgets:startsWith(arg, "--ram")?params.ramBudgets:params.budgets;
+        budgets.emplace_back(budget.substr(0, colon), size);
+        params.memory = params.memory || &budgets != &params.budgets;
+      }
+      else if(startsWith(arg, "-"))
+        return false;
+      else
+        params.maps.push_back(arg);
+    }
+  }
+  catch(...)
+  {
+    return false;
+  }
+
+  return !params.maps.empty();
+}
+}
+
+//##################################################################################################
+int main(int argc, const char* argv[])
+{
+  Params_lt params;
+  if(!parseArgs(argc, argv, params))
+  {
+    printUsage();
+    return 1;
+  }
+
+  Report_lt report;
+  for(const auto& map : params.maps)
+    if(!MapParser_lt(params.buildDirectory, report).parse(map))
+      return 1;
+
+  for(const auto& file : params.files)
+  {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(file, ec);
+    if(!ec)
+      report.files[std::filesystem::path(file).filename().string()] = size;
+  }
+
+  if(report.modules.empty())
+  {
+    std::cerr << "error: Nothing found in the map files, was the link run with -Wl,-Map?" << std::endl;
+    return 1;
+  }
+
+  Report_lt baseline;
+  bool hasBaseline = !params.baseline.empty() && loadReport(params.baseline, baseline);
+
+  std::cout << std::left << std::setw(40) << "Section" << std::right << std::setw(12) << "Bytes";
+  if(hasBaseline)
+    std::cout << "  Change";
+  std::cout << "\n";
+  for(const auto& [name, size] : report.sections)
+  {
+    std::cout << std::left << std::setw(40) << name << std::right << std::setw(12) << size;
+    if(hasBaseline)
+    {
+      auto b = baseline.sections.find(name);
+      std::cout << "  " << formatChange(b!=baseline.sections.end(), (b!=baseline.sections.end())?b->second:0, size);
+    }
+    std::cout << "\n";
+  }
+
+  std::map<std::string, size_t> budgets(params.budgets.begin(), params.budgets.end());
+  std::map<std::string, size_t> flashBudgets(params.flashBudgets.begin(), params.flashBudgets.end());
+  std::map<std::string, size_t> ramBudgets(params.ramBudgets.begin(), params.ramBudgets.end());
+  std::vector<std::string> overBudget;
+  auto checkBudget = [&](const std::map<std::string, size_t>& budgets, const std::string& type, const std::string& name, size_t size)
+  {
+    auto b = budgets.find(name);
+    if(b == budgets.end() || size<=b->second)
+      return false;
+    overBudget.push_back(name + type + ": " + std::to_string(size) + " > " + std::to_string(b->second));
+    return true;
+  };
+
+  auto budgetText = [](const std::map<std::string, size_t>& budgets, const std::string& name)
+  {
+    auto b = budgets.find(name);
+    return (b == budgets.end())?std::string("-"):std::to_string(b->second);
+  };
+
+  // Largest modules first, then the total.
+  std::vector<std::pair<std::string, Module_lt>> modules(report.modules.begin(), report.modules.end());
+  std::stable_sort(modules.begin(), modules.end(), [](const auto& a, const auto& b)
+  {
+    return a.second.total>b.second.total;
+  });
+
+  Module_lt& total = modules.emplace_back("total", Module_lt()).second;
+  total.total = report.total;
+  total.flash = report.flash;
+  total.ram = report.ram;
+
+  std::cout << "\n" << std::left << std::setw(40) << "Module" << std::right << std::setw(12) << "Bytes"
+            << std::setw(12) << "tp_rc" << std::setw(12) << "Budget";
+  if(params.memory)
+    std::cout << std::setw(12) << "Flash" << std::setw(12) << "RAM";
+  if(hasBaseline)
+    std::cout << "  Change";
+  std::cout << "\n";
+  for(const auto& [name, module] : modules)
+  {
+    bool over = checkBudget(budgets, "", name, module.total);
+    over = checkBudget(flashBudgets, " flash", name, module.flash) || over;
+    over = checkBudget(ramBudgets, " RAM", name, module.ram) || over;
+
+    std::string color = over?"\033[31m":"";
+    std::cout << color << std::left << std::setw(40) << name << std::right << std::setw(12) << module.total
+              << std::setw(12) << module.rc << std::setw(12) << budgetText(budgets, name);
+    if(params.memory)
+      std::cout << std::setw(12) << module.flash << std::setw(12) << module.ram;
+    if(hasBaseline)
+    {
+      auto b = baseline.modules.find(name);
+      if(name == "total")
+        std::cout << "  " << formatChange(true, baseline.total, module.total);
+      else
+        std::cout << "  " << formatChange(b!=baseline.modules.end(), (b!=baseline.modules.end())?b->second.total:0, module.total);
+    }
+    std::cout << (color.empty()?"":"\033[39m") << "\n";
+  }
+
+  for(const auto& [name, size] : report.files)
+  {
+    std::cout << "File: " << name << " " << size << " bytes";
+    if(hasBaseline)
+    {
+      auto b = baseline.files.find(name);
+      std::cout << "  " << formatChange(b!=baseline.files.end(), (b!=baseline.files.end())?b->second:0, size);
+    }
+    std::cout << "\n";
+  }
+
+  std::vector<std::pair<std::pair<std::string, std::string>, size_t>> symbols(report.symbols.begin(), report.symbols.end());
+  std::stable_sort(symbols.begin(), symbols.end(), [](const auto& a, const auto& b)
+  {
+    return a.second>b.second;
+  });
+
+  std::cout << "\nLargest symbols:\n";
+  for(size_t i=0; i<symbols.size() && i<params.symbols; i++)
+    std::cout << std::setw(12) << symbols.at(i).second << "  " << std::left << std::setw(24) << symbols.at(i).first.first << std::right << symbols.at(i).first.second << "\n";
+
+  // The symbols that grew or shrank the most explain a module change.
+  if(hasBaseline)
+  {
+    std::map<std::pair<std::string, std::string>, int64_t> changes;
+    for(const auto& [key, size] : report.symbols)
+      changes[key] += int64_t(size);
+    for(const auto& [key, size] : baseline.symbols)
+      changes[key] -= int64_t(size);
+
+    std::vector<std::pair<std::pair<std::string, std::string>, int64_t>> sorted;
+    for(const auto& change : changes)
+      if(change.second != 0)
+        sorted.push_back(change);
+    std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b)
+    {
+      return std::abs(a.second)>std::abs(b.second);
+    });
+
+    std::cout << "\nSymbol changes since the baseline:\n";
+    for(size_t i=0; i<sorted.size() && i<params.symbols; i++)
+      std::cout << std::setw(12) << std::showpos << sorted.at(i).second << std::noshowpos << "  " << std::left << std::setw(24) << sorted.at(i).first.first << std::right << sorted.at(i).first.second << "\n";
+  }
+  else if(!params.baseline.empty())
+    std::cout << "\nNo baseline found: " << params.baseline << "\n";
+
+  if(params.memory)
+  {
+    auto summary = [&](const char* type, const std::map<std::string, size_t>& budgets, size_t used)
+    {
+      std::cout << type << ": " << used << " bytes";
+      if(auto b = budgets.find("total"); b != budgets.end() && b->second>0)
+        std::cout << " of " << b->second << " (" << std::fixed << std::setprecision(1) << double(used)/double(b->second)*100.0 << "%)" << std::defaultfloat;
+      std::cout << "\n";
+    };
+
+    std::cout << "\n";
+    summary("Flash", flashBudgets, report.flash);
+    summary("RAM", ramBudgets, report.ram);
+  }
+
+  if(!params.save.empty())
+  {
+    if(!saveReport(params.save, report))
+      return 1;
+    std::cout << "\nSaved: " << params.save << "\n";
+  }
+
+  for(const auto& budget : overBudget)
+    std::cerr << "error: Over budget, " << budget << std::endl;
+
+  std::cout << std::flush;
+  return overBudget.empty()?0:1;
+}
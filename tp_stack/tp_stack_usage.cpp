@@ -0,0 +1,473 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <iomanip>
+#include <filesystem>
+
+namespace
+{
+
+//##################################################################################################
+struct Function_lt
+{
+  std::string name;     //!< Printable name, the key is the assembler name.
+  std::string location; //!< file:line:column
+  size_t stack{0};
+  bool defined{false};  //!< False for functions that were only declared, their usage is unknown.
+  bool dynamic{false};  //!< Uses alloca or VLAs without a known bound.
+  std::set<std::string> callees;
+  bool called{false};
+};
+
+//##################################################################################################
+struct Result_lt
+{
+  size_t depth{0};
+  std::vector<std::string> path;
+  bool recursive{false};
+  bool indirect{false};
+  bool dynamic{false};
+  bool unknown{false};
+  bool done{false};
+};
+
+//##################################################################################################
+struct Params_lt
+{
+  std::vector<std::string> directories;
+  std::vector<std::string> entries;
+  std::vector<std::pair<std::string, size_t>> budgets;
+  size_t unknownStack{0};
+  size_t top{20};
+};
+
+//##################################################################################################
+bool startsWith(const std::string& text, const std::string& prefix)
+{
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+//##################################################################################################
+//! Sizes like 2K.
+bool parseSize(const std::string& text, size_t& size)
+{
+  try
+  {
+    size_t end=0;
+    size = std::stoull(text, &end, 0);
+    std::string suffix = text.substr(end);
+    if(suffix == "K" || suffix == "k")
+      size *= 1024;
+    else if(!suffix.empty())
+      return false;
+    return true;
+  }
+  catch(...)
+  {
+    return false;
+  }
+}
+
+//##################################################################################################
+//! Read a quoted field like: title: "main"
+std::string field(const std::string& line, const std::string& key)
+{
+  auto start = line.find(key + ": \"");
+  if(start == std::string::npos)
+    return std::string();
+
+  std::string value;
+  for(size_t i=start+key.size()+3; i<line.size(); i++)
+  {
+    if(line.at(i) == '\\' && i+1<line.size() && line.at(i+1) == '"')
+      value += line.at(++i);
+    else if(line.at(i) == '"')
+      break;
+    else
+      value += line.at(i);
+  }
+  return value;
+}
+
+//##################################################################################################
+//! The .su files written by -fstack-usage: file:line:column:function<tab>bytes<tab>qualifiers
+void loadStackUsage(const std::filesystem::path& path, std::map<std::string, std::pair<size_t, bool>>& usage)
+{
+  std::ifstream in(path);
+  for(std::string line; std::getline(in, line);)
+  {
+    auto tab = line.find('\t');
+    auto tab2 = line.find('\t', tab+1);
+    if(tab == std::string::npos || tab2 == std::string::npos)
+      continue;
+
+    // The location is the first three fields, the function name can contain colons.
+    size_t colon = 0;
+    for(int i=0; i<3 && colon != std::string::npos; i++)
+      colon = line.find(':', colon+1);
+    if(colon == std::string::npos || colon>tab)
+      continue;
+
+    try
+    {
+      std::string qualifier = line.substr(tab2+1);
+      bool dynamic = startsWith(qualifier, "dynamic") && qualifier.find("bounded") == std::string::npos;
+      usage[line.substr(0, colon)] = {std::stoull(line.substr(tab+1, tab2-tab-1)), dynamic};
+    }
+    catch(...)
+    {
+    }
+  }
+}
+
+//##################################################################################################
+//! The .ci files written by -fcallgraph-info=su are VCG graphs with a node for each function.
+void loadCallGraph(const std::filesystem::path& path, std::map<std::string, Function_lt>& functions)
+{
+  std::ifstream in(path);
+  for(std::string line; std::getline(in, line);)
+  {
+    if(startsWith(line, "node:"))
+    {
+      std::string title = field(line, "title");
+      std::vector<std::string> label;
+      {
+        std::string text = field(line, "label");
+        for(size_t start=0;;)
+        {
+          auto end = text.find("\\n", start);
+          label.push_back(text.substr(start, end-start));
+          if(end == std::string::npos)
+            break;
+          start = end+2;
+        }
+      }
+
+      Function_lt& function = functions[title];
+      bool defined = label.size()>2 && label.at(2).find(" bytes") != std::string::npos;
+      if(function.defined && !defined)
+        continue;
+
+      // GCC sometimes writes a truncated label for declarations, the assembler name is still useful.
+      function.name = (label.at(0).empty() || label.at(0).front() == ')')?title:label.at(0);
+      function.location = (label.size()>1)?label.at(1):std::string();
+      function.defined = defined;
+      if(defined)
+      {
+        function.stack = std::stoull(label.at(2));
+        function.dynamic = label.at(2).find("(dynamic") != std::string::npos && label.at(2).find("bounded") == std::string::npos;
+      }
+    }
+    else if(startsWith(line, "edge:"))
+    {
+      std::string source = field(line, "sourcename");
+      std::string target = field(line, "targetname");
+      functions[source].callees.insert(target);
+      functions[target].called = true;
+    }
+  }
+}
+
+//##################################################################################################
+class Analysis_lt
+{
+public:
+  //################################################################################################
+  Analysis_lt(const std::map<std::string, Function_lt>& functions, size_t unknownStack):
+    m_functions(functions),
+    m_unknownStack(unknownStack)
+  {
+
+  }
+
+  //################################################################################################
+  //! Worst case stack depth from a function, recursion is followed once and flagged.
+  const Result_lt& worstCase(const std::string& title)
+  {
+    Result_lt& result = m_results[title];
+    if(result.done)
+      return result;
+
+    if(m_active.count(title))
+    {
+      m_recursion = true;
+      static const Result_lt cycle;
+      return cycle;
+    }
+
+    auto f = m_functions.find(title);
+    if(f == m_functions.end() || !f->second.defined)
+    {
+      result.done = true;
+      result.indirect = (title == "__indirect_call");
+      result.unknown = !result.indirect;
+      result.depth = result.indirect?0:m_unknownStack;
+      result.path = {title};
+      return result;
+    }
+
+    m_active.insert(title);
+    bool recursionBefore = m_recursion;
+    m_recursion = false;
+
+    Result_lt worst;
+    for(const auto& callee : f->second.callees)
+    {
+      const Result_lt& r = worstCase(callee);
+      if(worst.path.empty() || r.depth>worst.depth)
+      {
+        worst.depth = r.depth;
+        worst.path = r.path;
+      }
+
+      worst.recursive = worst.recursive || r.recursive;
+      worst.indirect = worst.indirect || r.indirect;
+      worst.dynamic = worst.dynamic || r.dynamic;
+      worst.unknown = worst.unknown || r.unknown;
+    }
+
+    m_active.erase(title);
+
+    Result_lt& stored = m_results[title];
+    stored = worst;
+    stored.depth += f->second.stack;
+    stored.path.insert(stored.path.begin(), title);
+    stored.recursive = stored.recursive || m_recursion;
+    stored.dynamic = stored.dynamic || f->second.dynamic;
+    stored.done = true;
+    m_recursion = recursionBefore || m_recursion;
+    return stored;
+  }
+
+private:
+  const std::map<std::string, Function_lt>& m_functions;
+  size_t m_unknownStack;
+  std::map<std::string, Result_lt> m_results;
+  std::set<std::string> m_active;
+  bool m_recursion{false};
+};
+
+//##################################################################################################
+void printUsage()
+{
+  std::cerr << "Usage: tpStackUsage [options] <directories...>\n"
+               "  Combines the .su and .ci files written by -fstack-usage -fcallgraph-info=su to find the\n"
+               "  worst case stack depth of each entry point, for example main, interrupt handlers and\n"
+               "  thread functions.\n"
+               "  --entry=NAME          Entry point to report, default: every function that is not called.\n"
+               "  --budget=ENTRY:SIZE   Fail if the worst case of ENTRY is larger than SIZE bytes, or can't\n"
+               "                        be bounded. Use * for every entry point without its own budget.\n"
+               "  --unknown=BYTES       Stack assumed for functions without stack usage, default: 0\n"
+               "  --top=N               Number of entry points and frames to list, default: 20\n";
+}
+
+//##################################################################################################
+bool parseArgs(int argc, const char* argv[], Params_lt& params)
+{
+  try
+  {
+    for(int i=1; i<argc; i++)
+    {
+      std::string arg = argv[i];
+      if(startsWith(arg, "--entry="))
+        params.entries.push_back(arg.substr(8));
+      else if(startsWith(arg, "--unknown="))
+        params.unknownStack = std::stoull(arg.substr(10));
+      else if(startsWith(arg, "--top="))
+        params.top = std::stoull(arg.substr(6));
+      else if(startsWith(arg, "--budget="))
+      {
+        std::string budget = arg.substr(9);
+        auto colon = budget.rfind(':');
+        size_t size=0;
+        if(colon == std::string::npos || !parseSize(budget.substr(colon+1), size))
+          return false;
+        params.budgets.emplace_back(budget.substr(0, colon), size);
+      }
+      else if(startsWith(arg, "-"))
+        return false;
+      else
+        params.directories.push_back(arg);
+    }
+  }
+  catch(...)
+  {
+    return false;
+  }
+
+  return !params.directories.empty();
+}
+}
+
+//##################################################################################################
+int main(int argc, const char* argv[])
+{
+  Params_lt params;
+  if(!parseArgs(argc, argv, params))
+  {
+    printUsage();
+    return 1;
+  }
+
+  std::map<std::string, std::pair<size_t, bool>> usage;
+  std::map<std::string, Function_lt> functions;
+  for(const auto& directory : params.directories)
+  {
+    std::error_code ec;
+    for(const auto& entry : std::filesystem::recursive_directory_iterator(directory, ec))
+    {
+      if(entry.path().extension() == ".su")
+        loadStackUsage(entry.path(), usage);
+      else if(entry.path().extension() == ".ci")
+        loadCallGraph(entry.path(), functions);
+    }
+  }
+
+  if(functions.empty())
+  {
+    std::cerr << "error: No call graphs found, build with TP_STACK_USAGE=1 using GCC 10 or later." << std::endl;
+    return 1;
+  }
+
+  // The .su files are the reference for the frame sizes, the call graph only gives the structure.
+  for(auto& [title, function] : functions)
+  {
+    if(auto u = usage.find(function.location); function.defined && u != usage.end())
+    {
+      function.stack = u->second.first;
+      function.dynamic = u->second.second;
+    }
+  }
+
+  auto findEntry = [&](const std::string& name)
+  {
+    if(functions.count(name))
+      return name;
+    for(const auto& [title, function] : functions)
+      if(function.name == name || startsWith(function.name, name + "(") || function.name.find(" " + name + "(") != std::string::npos)
+        return title;
+    return std::string();
+  };
+
+  std::vector<std::string> entries;
+  if(params.entries.empty())
+  {
+    for(const auto& [title, function] : functions)
+      if(function.defined && !function.called)
+        entries.push_back(title);
+  }
+  else
+  {
+    for(const auto& name : params.entries)
+    {
+      auto title = findEntry(name);
+      if(title.empty())
+      {
+        std::cerr << "error: Entry point not found: " << name << std::endl;
+        return 1;
+      }
+      entries.push_back(title);
+    }
+  }
+
+  Analysis_lt analysis(functions, params.unknownStack);
+  std::vector<std::pair<std::string, Result_lt>> results;
+  for(const auto& title : entries)
+    results.emplace_back(title, analysis.worstCase(title));
+
+  std::stable_sort(results.begin(), results.end(), [](const auto& a, const auto& b)
+  {
+    return a.second.depth>b.second.depth;
+  });
+
+  std::map<std::string, size_t> budgets;
+  for(const auto& [name, size] : params.budgets)
+    budgets[(name=="*")?name:findEntry(name)] = size;
+
+  auto displayName = [&](const std::string& title)
+  {
+    auto f = functions.find(title);
+    return (f!=functions.end() && !f->second.name.empty())?f->second.name:title;
+  };
+
+  std::vector<std::string> failures;
+  std::cout << std::left << std::setw(60) << "Entry point" << std::right << std::setw(12) << "Worst case" << std::setw(12) << "Budget" << "  Notes\n";
+  size_t count=0;
+  for(const auto& [title, result] : results)
+  {
+    auto b = budgets.find(title);
+    if(b == budgets.end())
+      b = budgets.find("*");
+    bool hasBudget = (b != budgets.end());
+    bool bounded = !result.recursive && !result.dynamic && !result.indirect;
+
+    std::string notes;
+    if(result.recursive)
+      notes += " recursion";
+    if(result.dynamic)
+      notes += " dynamic";
+    if(result.indirect)
+      notes += " indirect-calls";
+    if(result.unknown)
+      notes += " unknown-callees";
+
+    bool failed = hasBudget && (result.depth>b->second || !bounded);
+    if(failed)
+      failures.push_back(displayName(title) + ": " + std::to_string(result.depth) + (bounded?" > ":" (unbounded) budget ") + std::to_string(b->second));
+
+    if(count++>=params.top && !failed)
+      continue;
+
+    std::string color = failed?"\033[31m":"";
+    std::cout << color << std::left << std::setw(60) << displayName(title) << std::right << std::setw(12) << result.depth
+              << std::setw(12) << (hasBudget?std::to_string(b->second):std::string("-")) << " " << notes << (color.empty()?"":"\033[39m") << "\n";
+
+    std::cout << "    ";
+    for(size_t i=0; i<result.path.size(); i++)
+    {
+      auto f = functions.find(result.path.at(i));
+      std::cout << ((i>0)?" -> ":"") << displayName(result.path.at(i)) << " (" << ((f!=functions.end() && f->second.defined)?std::to_string(f->second.stack):std::string("?")) << ")";
+    }
+    std::cout << "\n";
+  }
+
+  // Large frames are the easiest stack to save, often a buffer that could be static or on the heap.
+  std::vector<const Function_lt*> frames;
+  std::set<std::string> unknown;
+  for(const auto& [title, function] : functions)
+  {
+    if(function.defined)
+      frames.push_back(&function);
+    else if(function.called && title != "__indirect_call")
+      unknown.insert(function.name.empty()?title:function.name);
+  }
+
+  std::stable_sort(frames.begin(), frames.end(), [](const auto* a, const auto* b)
+  {
+    return a->stack>b->stack;
+  });
+
+  std::cout << "\nLargest frames:\n";
+  for(size_t i=0; i<frames.size() && i<params.top; i++)
+    std::cout << std::setw(12) << frames.at(i)->stack << "  " << frames.at(i)->name << "  " << frames.at(i)->location << (frames.at(i)->dynamic?" dynamic":"") << "\n";
+
+  if(!unknown.empty())
+  {
+    std::cout << "\nNo stack usage for " << unknown.size() << " called function(s), assumed " << params.unknownStack << " bytes each:\n";
+    size_t i=0;
+    for(const auto& name : unknown)
+      if(i++<params.top)
+        std::cout << "  " << name << "\n";
+  }
+
+  std::cout << std::flush;
+  for(const auto& failure : failures)
+    std::cerr << "error: Stack budget exceeded, " << failure << std::endl;
+
+  return failures.empty()?0:1;
+}
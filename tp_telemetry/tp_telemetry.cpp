@@ -0,0 +1,618 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+//##################################################################################################
+struct Params_lt
+{
+  std::string command;              //!< run or report.
+  std::string logFile;
+  std::string name;
+  std::string traceFile;
+  size_t top{10};
+  std::vector<std::string> positional;
+};
+
+//##################################################################################################
+//! One line of the log, times are in microseconds and the start and end are since the epoch so
+//! that records written by commands running in parallel line up.
+struct Record_lt
+{
+  int64_t start{0};
+  int64_t end{0};
+  int64_t user{0};
+  int64_t sys{0};
+  int64_t maxRSS{0};                //!< KiB, the largest of the command and its child processes.
+  int status{0};
+  std::string name;
+  std::vector<std::string> outputs;
+  std::vector<std::string> inputs;
+
+  int64_t wall() const {return end-start;}
+  int64_t cpu() const {return user+sys;}
+};
+
+//##################################################################################################
+int64_t nowMicroseconds()
+{
+  using namespace std::chrono;
+  return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+//##################################################################################################
+//! Arguments that may be files: plain arguments, response files, the value of -oFILE and of
+//! --option=FILE.
+std::vector<std::string> candidatePaths(const std::vector<std::string>& args)
+{
+  std::vector<std::string> paths;
+  for(size_t i=1; i<args.size(); i++)
+  {
+    const auto& arg = args.at(i);
+    if(arg.empty())
+      continue;
+
+    if(arg.front() == '@')
+      paths.push_back(arg.substr(1));
+    else if(arg.front() != '-')
+      paths.push_back(arg);
+    else if(arg.size()>2 && arg.compare(0, 2, "-o") == 0)
+      paths.push_back(arg.substr(2));
+    else if(auto equals = arg.find('='); equals != std::string::npos)
+      paths.push_back(arg.substr(equals+1));
+  }
+  return paths;
+}
+
+//##################################################################################################
+//! The name of the program that does the work, looking past launchers like tpCache.
+std::string toolName(const std::vector<std::string>& args)
+{
+  size_t i=0;
+  auto name = fs::path(args.front()).filename().string();
+  if(name == "tpCache")
+  {
+    auto separator = std::find(args.begin(), args.end(), "--");
+    i = size_t(separator-args.begin())+1;
+  }
+  else if(name == "ccache" || name == "sccache")
+    i = 1;
+
+  return (i>0 && i<args.size())?fs::path(args.at(i)).filename().string():name;
+}
+
+//##################################################################################################
+//! The file after -o, listed first as it names the command in the report.
+std::string primaryOutput(const std::vector<std::string>& args)
+{
+  for(size_t i=1; i<args.size(); i++)
+  {
+    const auto& arg = args.at(i);
+    if(arg == "-o" && i+1<args.size())
+      return args.at(i+1);
+    if(arg.size()>2 && arg.compare(0, 2, "-o") == 0)
+      return arg.substr(2);
+  }
+  return std::string();
+}
+
+//##################################################################################################
+struct FileState_lt
+{
+  bool exists{false};
+  fs::file_time_type time;
+};
+
+//##################################################################################################
+FileState_lt fileState(const std::string& path)
+{
+  FileState_lt state;
+  std::error_code ec;
+  if(fs::is_regular_file(path, ec))
+  {
+    state.time = fs::last_write_time(path, ec);
+    state.exists = !ec;
+  }
+  return state;
+}
+
+//##################################################################################################
+std::string joinList(const std::vector<std::string>& items)
+{
+  std::string result;
+  for(const auto& item : items)
+  {
+    if(!result.empty())
+      result += ' ';
+    result += item;
+  }
+  return result;
+}
+
+//##################################################################################################
+std::vector<std::string> splitList(const std::string& text)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(text);
+  std::string item;
+  while(ss >> item)
+    items.push_back(item);
+  return items;
+}
+
+//##################################################################################################
+//! Each record is written with a single append so that commands running in parallel don't mix
+//! their lines.
+void appendRecord(const std::string& logFile, const Record_lt& record)
+{
+  std::string line = std::to_string(record.start) + '\t' +
+      std::to_string(record.end) + '\t' +
+      std::to_string(record.user) + '\t' +
+      std::to_string(record.sys) + '\t' +
+      std::to_string(record.maxRSS) + '\t' +
+      std::to_string(record.status) + '\t' +
+      record.name + '\t' +
+      joinList(record.outputs) + '\t' +
+      joinList(record.inputs) + '\n';
+
+#ifndef _WIN32
+  int fd = open(logFile.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if(fd<0)
+  {
+    std::cerr << "warning: Failed to write: " << logFile << std::endl;
+    return;
+  }
+  if(write(fd, line.data(), line.size()) != ssize_t(line.size()))
+    std::cerr << "warning: Failed to write: " << logFile << std::endl;
+  close(fd);
+#else
+  std::ofstream(logFile, std::ios::app | std::ios::binary) << line;
+#endif
+}
+
+//##################################################################################################
+//! Runs the command and records its times, memory and the files it read and wrote. Files named on
+//! the command line that are new or changed afterwards are outputs, the rest are inputs.
+int run(const Params_lt& params)
+{
+  const auto& args = params.positional;
+  auto paths = candidatePaths(args);
+
+  std::vector<FileState_lt> before;
+  before.reserve(paths.size());
+  for(const auto& path : paths)
+    before.push_back(fileState(path));
+
+  Record_lt record;
+  record.name = params.name.empty()?toolName(args):params.name;
+  record.start = nowMicroseconds();
+
+#ifndef _WIN32
+  std::vector<char*> argv;
+  for(const auto& arg : args)
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  argv.push_back(nullptr);
+
+  pid_t pid = fork();
+  if(pid<0)
+  {
+    std::cerr << "error: Failed to run: " << args.front() << std::endl;
+    return 1;
+  }
+
+  if(pid==0)
+  {
+    execvp(argv.front(), argv.data());
+    std::cerr << "error: Failed to run: " << args.front() << ": " << std::strerror(errno) << std::endl;
+    _exit(127);
+  }
+
+  // The usage of the child includes the processes it waited for, cc1plus, as, collect2 and ld.
+  int status=0;
+  struct rusage usage{};
+  while(wait4(pid, &status, 0, &usage)<0)
+  {
+    if(errno != EINTR)
+    {
+      status = 1<<8;
+      break;
+    }
+  }
+
+  record.end = nowMicroseconds();
+  record.status = WIFEXITED(status)?WEXITSTATUS(status):128+WTERMSIG(status);
+  record.user = int64_t(usage.ru_utime.tv_sec)*1000000 + usage.ru_utime.tv_usec;
+  record.sys = int64_t(usage.ru_stime.tv_sec)*1000000 + usage.ru_stime.tv_usec;
+#ifdef __APPLE__
+  record.maxRSS = usage.ru_maxrss/1024;
+#else
+  record.maxRSS = usage.ru_maxrss;
+#endif
+#else
+  std::string command;
+  for(const auto& arg : args)
+    command += "\"" + arg + "\" ";
+  record.status = std::system(command.c_str());
+  record.end = nowMicroseconds();
+#endif
+
+  std::set<std::string> seen;
+  for(size_t i=0; i<paths.size(); i++)
+  {
+    const auto& path = paths.at(i);
+    if(!seen.insert(path).second)
+      continue;
+
+    auto after = fileState(path);
+    if(after.exists && (!before.at(i).exists || after.time != before.at(i).time))
+      record.outputs.push_back(path);
+    else if(before.at(i).exists)
+      record.inputs.push_back(path);
+  }
+
+  if(auto output = std::find(record.outputs.begin(), record.outputs.end(), primaryOutput(args)); output != record.outputs.end())
+    std::rotate(record.outputs.begin(), output, output+1);
+
+  appendRecord(params.logFile, record);
+  return record.status;
+}
+
+//##################################################################################################
+bool loadRecords(const std::string& logFile, std::vector<Record_lt>& records)
+{
+  std::ifstream in(logFile);
+  if(!in)
+  {
+    std::cerr << "error: Failed to read: " << logFile << std::endl;
+    return false;
+  }
+
+  std::string line;
+  while(std::getline(in, line))
+  {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while(std::getline(ss, field, '\t'))
+      fields.push_back(field);
+
+    // Outputs and inputs can be empty so the last fields may be missing.
+    if(fields.size()<7)
+      continue;
+    fields.resize(9);
+
+    try
+    {
+      Record_lt record;
+      record.start = std::stoll(fields.at(0));
+      record.end = std::stoll(fields.at(1));
+      record.user = std::stoll(fields.at(2));
+      record.sys = std::stoll(fields.at(3));
+      record.maxRSS = std::stoll(fields.at(4));
+      record.status = std::stoi(fields.at(5));
+      record.name = fields.at(6);
+      record.outputs = splitList(fields.at(7));
+      record.inputs = splitList(fields.at(8));
+      records.push_back(std::move(record));
+    }
+    catch(...)
+    {
+    }
+  }
+
+  return true;
+}
+
+//##################################################################################################
+std::string label(const Record_lt& record)
+{
+  if(!record.outputs.empty())
+    return record.outputs.front();
+  if(!record.inputs.empty())
+    return record.name + " " + record.inputs.back();
+  return record.name;
+}
+
+//##################################################################################################
+std::string seconds(int64_t us)
+{
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(2) << double(us)/1e6 << "s";
+  return ss.str();
+}
+
+//##################################################################################################
+std::string megabytes(int64_t kib)
+{
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(1) << double(kib)/1024.0 << "MiB";
+  return ss.str();
+}
+
+//##################################################################################################
+std::string jsonEscape(const std::string& text)
+{
+  std::string result;
+  for(char c : text)
+  {
+    if(c=='"' || c=='\\')
+      result += '\\';
+    result += c;
+  }
+  return result;
+}
+
+//##################################################################################################
+//! The sum of the peak memory of the commands that are running at the same time, an upper bound of
+//! the memory that the build needs at that point.
+std::vector<std::pair<int64_t, int64_t>> concurrentMemory(const std::vector<Record_lt>& records)
+{
+  std::vector<std::pair<int64_t, int64_t>> changes;
+  for(const auto& record : records)
+  {
+    changes.emplace_back(record.start, record.maxRSS);
+    changes.emplace_back(record.end, -record.maxRSS);
+  }
+  std::sort(changes.begin(), changes.end());
+
+  std::vector<std::pair<int64_t, int64_t>> results;
+  int64_t total=0;
+  for(const auto& change : changes)
+  {
+    total += change.second;
+    if(!results.empty() && results.back().first == change.first)
+      results.back().second = total;
+    else
+      results.emplace_back(change.first, total);
+  }
+  return results;
+}
+
+//##################################################################################################
+void printSummary(const Params_lt& params, std::vector<Record_lt> records)
+{
+  int64_t first=records.front().start;
+  int64_t last=records.front().end;
+  int64_t wall=0;
+  int64_t cpu=0;
+  size_t failed=0;
+  for(const auto& record : records)
+  {
+    first = std::min(first, record.start);
+    last = std::max(last, record.end);
+    wall += record.wall();
+    cpu += record.cpu();
+    failed += (record.status!=0)?1:0;
+  }
+
+  int64_t peakMemory=0;
+  for(const auto& point : concurrentMemory(records))
+    peakMemory = std::max(peakMemory, point.second);
+
+  int64_t span = std::max<int64_t>(1, last-first);
+  std::cout << "Commands: " << records.size() << " (" << failed << " failed)\n"
+            << "Build span: " << seconds(span) << "\n"
+            << "Command time: " << seconds(wall) << " wall, " << seconds(cpu) << " CPU, "
+            << std::fixed << std::setprecision(2) << double(wall)/double(span) << " average parallelism\n"
+            << "Peak memory of concurrent commands: " << megabytes(peakMemory) << "\n";
+
+  struct Tool_lt
+  {
+    size_t count{0};
+    int64_t wall{0};
+    int64_t cpu{0};
+    int64_t maxRSS{0};
+  };
+
+  std::map<std::string, Tool_lt> tools;
+  for(const auto& record : records)
+  {
+    auto& tool = tools[record.name];
+    tool.count++;
+    tool.wall += record.wall();
+    tool.cpu += record.cpu();
+    tool.maxRSS = std::max(tool.maxRSS, record.maxRSS);
+  }
+
+  std::vector<std::pair<std::string, Tool_lt>> sortedTools(tools.begin(), tools.end());
+  std::sort(sortedTools.begin(), sortedTools.end(), [](const auto& a, const auto& b){return a.second.wall>b.second.wall;});
+
+  std::cout << "\nBy tool:\n";
+  for(const auto& [name, tool] : sortedTools)
+    std::cout << "  " << std::setw(10) << seconds(tool.wall) << " wall " << std::setw(10) << seconds(tool.cpu) << " CPU "
+              << std::setw(10) << megabytes(tool.maxRSS) << " max  " << tool.count << " x " << name << "\n";
+
+  size_t top = std::min(params.top, records.size());
+
+  std::sort(records.begin(), records.end(), [](const auto& a, const auto& b){return a.wall()>b.wall();});
+  std::cout << "\nSlowest commands:\n";
+  for(size_t i=0; i<top; i++)
+  {
+    const auto& record = records.at(i);
+    std::cout << "  " << std::setw(10) << seconds(record.wall()) << " wall " << std::setw(10) << seconds(record.cpu()) << " CPU "
+              << std::setw(10) << megabytes(record.maxRSS) << "  " << label(record) << "\n";
+  }
+
+  std::sort(records.begin(), records.end(), [](const auto& a, const auto& b){return a.maxRSS>b.maxRSS;});
+  std::cout << "\nLargest peak memory:\n";
+  for(size_t i=0; i<top; i++)
+  {
+    const auto& record = records.at(i);
+    std::cout << "  " << std::setw(10) << megabytes(record.maxRSS) << " " << std::setw(10) << seconds(record.wall()) << " wall  " << label(record) << "\n";
+  }
+}
+
+//##################################################################################################
+//! Commands are placed on the first free lane so the trace shows how many ran at the same time.
+bool writeTrace(const Params_lt& params, std::vector<Record_lt> records)
+{
+  std::ofstream out(params.traceFile);
+  if(!out)
+  {
+    std::cerr << "error: Failed to write: " << params.traceFile << std::endl;
+    return false;
+  }
+
+  std::sort(records.begin(), records.end(), [](const auto& a, const auto& b){return a.start<b.start;});
+  int64_t first = records.front().start;
+
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"build\"}}";
+
+  std::vector<int64_t> laneEnds;
+  for(const auto& record : records)
+  {
+    size_t lane=0;
+    while(lane<laneEnds.size() && laneEnds.at(lane)>record.start)
+      lane++;
+    if(lane==laneEnds.size())
+    {
+      laneEnds.push_back(0);
+      out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << lane << ",\"args\":{\"name\":\"lane " << lane << "\"}}";
+    }
+    laneEnds.at(lane) = record.end;
+
+    out << ",\n{\"name\":\"" << jsonEscape(label(record)) << "\""
+        << ",\"cat\":\"" << jsonEscape(record.name) << "\""
+        << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << lane
+        << ",\"ts\":" << record.start-first
+        << ",\"dur\":" << record.wall()
+        << ",\"args\":{\"user_ms\":" << record.user/1000
+        << ",\"sys_ms\":" << record.sys/1000
+        << ",\"max_rss_kb\":" << record.maxRSS
+        << ",\"status\":" << record.status
+        << ",\"outputs\":\"" << jsonEscape(joinList(record.outputs)) << "\""
+        << ",\"inputs\":\"" << jsonEscape(joinList(record.inputs)) << "\"}}";
+  }
+
+  for(const auto& point : concurrentMemory(records))
+    out << ",\n{\"name\":\"memory\",\"ph\":\"C\",\"pid\":0,\"ts\":" << point.first-first
+        << ",\"args\":{\"MiB\":" << point.second/1024 << "}}";
+
+  out << "\n]}\n";
+
+  std::cout << "\nWrote a trace of " << records.size() << " commands to: " << params.traceFile << std::endl;
+  return true;
+}
+
+//##################################################################################################
+int report(const Params_lt& params)
+{
+  std::vector<Record_lt> records;
+  for(const auto& logFile : params.positional)
+    if(!loadRecords(logFile, records))
+      return 1;
+
+  if(records.empty())
+  {
+    std::cerr << "error: No commands recorded." << std::endl;
+    return 1;
+  }
+
+  printSummary(params, records);
+
+  if(!params.traceFile.empty() && !writeTrace(params, records))
+    return 1;
+
+  return 0;
+}
+
+//##################################################################################################
+void printUsage()
+{
+  std::cerr << "Usage: tpTelemetry <command> [options]\n"
+               "\n"
+               "  tpTelemetry run --log=FILE [--name=NAME] -- <command...>\n"
+               "    Runs a command and appends its wall time, user and system time, peak memory and\n"
+               "    the files it read and wrote to the log.\n"
+               "    --name=NAME  Tool name in the report, defaults to the name of the program.\n"
+               "\n"
+               "  tpTelemetry report [--trace=FILE] [--top=N] <logs...>\n"
+               "    Prints the time and memory used by each tool and the largest commands.\n"
+               "    --trace=FILE  Write a Chrome trace of the commands and their memory.\n"
+               "    --top=N       Number of the largest commands to list, default: 10\n";
+}
+
+//##################################################################################################
+bool parseArgs(int argc, const char* argv[], Params_lt& params)
+{
+  if(argc<2)
+    return false;
+
+  params.command = argv[1];
+  try
+  {
+    for(int i=2; i<argc; i++)
+    {
+      std::string arg = argv[i];
+      if(arg == "--" && params.command == "run")
+      {
+        for(i++; i<argc; i++)
+          params.positional.push_back(argv[i]);
+      }
+      else if(arg.compare(0, 6, "--log=") == 0)
+        params.logFile = arg.substr(6);
+      else if(arg.compare(0, 7, "--name=") == 0)
+        params.name = arg.substr(7);
+      else if(arg.compare(0, 8, "--trace=") == 0)
+        params.traceFile = arg.substr(8);
+      else if(arg.compare(0, 6, "--top=") == 0)
+        params.top = size_t(std::stoul(arg.substr(6)));
+      else if(arg.compare(0, 1, "-") == 0)
+        return false;
+      else
+        params.positional.push_back(arg);
+    }
+  }
+  catch(...)
+  {
+    return false;
+  }
+
+  if(params.command == "run")
+    return !params.logFile.empty() && !params.positional.empty();
+
+  if(params.command == "report")
+    return !params.positional.empty();
+
+  return false;
+}
+}
+
+//##################################################################################################
+int main(int argc, const char* argv[])
+{
+  Params_lt params;
+  if(!parseArgs(argc, argv, params))
+  {
+    printUsage();
+    return 1;
+  }
+
+  if(params.command == "run")
+    return run(params);
+
+  return report(params);
+}
@@ -1,19 +1,8 @@
 #!/bin/bash
 
-set -e
+# Runs each of the tests listed in tests.txt using tpTest, any arguments are passed on to tpTest.
+#   ./run_tests.sh -j8 --timeout=300
 
-testCommands=`cat tests.txt`
-
-results="\nTest Results:\n"
-for testCommand in ${testCommands[@]}; do
-  echo -e "\n\e[1;93mRunning test: \e[21m${testCommand}\e[39m"
-
-  if ${testCommand}; then
-    results="${results}    \e[32mPassed: ${testCommand}\e[39m\n"
-  else
-    results="${results}    \e[31mFailed: ${testCommand}\e[39m\n"
-  fi
-done
-
-echo -e "${results}"
+cd "$(dirname "$0")"
 
+exec ./tpTest --junit=test_results.xml --json=test_results.json "$@" tests.txt
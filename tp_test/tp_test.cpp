@@ -0,0 +1,733 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cctype>
+#include <cstdint>
+#include <memory>
+
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "../tp_bench/inc/tp_bench/PerfCounters.h"
+
+namespace
+{
+
+//##################################################################################################
+struct Params_lt
+{
+  std::string testsFile{"tests.txt"};
+  std::string junitFile;
+  std::string jsonFile;
+  std::vector<std::string> historyFiles;
+  std::string logDirectory{"test_logs"};
+  size_t jobs{0};
+  double timeout{0.0};
+  size_t shardIndex{1};
+  size_t shardCount{1};
+  bool dryRun{false};
+  bool perfCounters{false};
+  bool pinCpus{false};
+};
+
+//##################################################################################################
+struct Test_lt
+{
+  std::string command;
+  std::string logFile;
+  double expectedSeconds{-1.0};
+
+  pid_t pid{0};
+  size_t slot{0};
+  std::chrono::steady_clock::time_point start;
+  std::shared_ptr<tp_bench::PerfCounters> perfCounters;
+  bool timedOut{false};
+  bool killed{false};
+
+  bool passed{false};
+  int exitCode{0};
+  int signal{0};
+  double wallSeconds{0.0};
+  double userSeconds{0.0};
+  double systemSeconds{0.0};
+  long peakRssKb{0};
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+//##################################################################################################
+bool readTextFile(const std::string& fileName, std::string& results)
+{
+  std::ifstream in(fileName, std::ios::binary);
+  if(!in)
+    return false;
+
+  std::stringstream ss;
+  ss << in.rdbuf();
+  results = ss.str();
+  return true;
+}
+
+//##################################################################################################
+std::vector<std::string> splitLines(const std::string& text)
+{
+  std::vector<std::string> lines;
+  std::stringstream ss(text);
+  std::string line;
+  while(std::getline(ss, line))
+  {
+    if(!line.empty() && line.back() == '\r')
+      line.pop_back();
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+//##################################################################################################
+std::vector<std::string> splitWords(const std::string& text)
+{
+  std::vector<std::string> words;
+  std::stringstream ss(text);
+  std::string word;
+  while(ss >> word)
+    words.push_back(word);
+  return words;
+}
+
+//##################################################################################################
+std::string escapeJSON(const std::string& text)
+{
+  std::string result;
+  for(char c : text)
+  {
+    switch(c)
+    {
+    case '"':  result += "\\\""; break;
+    case '\\': result += "\\\\"; break;
+    case '\n': result += "\\n";  break;
+    case '\t': result += "\\t";  break;
+    default:
+      if(uint8_t(c)<0x20)
+        result += ' ';
+      else
+        result += c;
+    }
+  }
+  return result;
+}
+
+//##################################################################################################
+std::string escapeXML(const std::string& text)
+{
+  std::string result;
+  for(char c : text)
+  {
+    switch(c)
+    {
+    case '&':  result += "&amp;";  break;
+    case '<':  result += "&lt;";   break;
+    case '>':  result += "&gt;";   break;
+    case '"':  result += "&quot;"; break;
+    case '\'': result += "&apos;"; break;
+    default:
+      if(uint8_t(c)<0x20 && c!='\n' && c!='\t')
+        result += ' ';
+      else
+        result += c;
+    }
+  }
+  return result;
+}
+
+//##################################################################################################
+//! Find the value of a "key": value pair in a single line of JSON as written by writeJSON.
+bool findJSONValue(const std::string& line, const std::string& key, std::string& value)
+{
+  std::string pattern = "\"" + key + "\": ";
+  auto i = line.find(pattern);
+  if(i == std::string::npos)
+    return false;
+
+  i += pattern.size();
+  if(i<line.size() && line.at(i) == '"')
+  {
+    i++;
+    for(; i<line.size() && line.at(i)!='"'; i++)
+    {
+      if(line.at(i) == '\\' && (i+1)<line.size())
+        i++;
+      value += line.at(i);
+    }
+    return true;
+  }
+
+  auto end = line.find_first_of(",}", i);
+  value = line.substr(i, end-i);
+  return true;
+}
+
+//##################################################################################################
+//! Load the wall time of each test from the JSON report of a previous run.
+void loadHistory(const std::string& fileName, std::map<std::string, double>& history)
+{
+  std::string text;
+  if(!readTextFile(fileName, text))
+    return;
+
+  for(const auto& line : splitLines(text))
+  {
+    std::string name;
+    std::string wall;
+    if(findJSONValue(line, "name", name) && findJSONValue(line, "wallSeconds", wall))
+    {
+      try
+      {
+        history[name] = std::stod(wall);
+      }
+      catch(...)
+      {
+      }
+    }
+  }
+}
+
+//##################################################################################################
+//! Split the tests into shardCount buckets of similar total duration and return the tests in bucket
+//! shardIndex. Every worker must pass the same tests and history to get a consistent split.
+std::vector<Test_lt> selectShard(std::vector<Test_lt> tests, const Params_lt& params)
+{
+  if(params.shardCount<2)
+    return tests;
+
+  // Tests without history are assumed to take the median time of the tests that we do know about.
+  std::vector<double> known;
+  for(const auto& test : tests)
+    if(test.expectedSeconds>=0.0)
+      known.push_back(test.expectedSeconds);
+
+  double estimate=1.0;
+  if(!known.empty())
+  {
+    std::sort(known.begin(), known.end());
+    estimate = known.at(known.size()/2);
+  }
+
+  auto expected = [&](const Test_lt& test)
+  {
+    return (test.expectedSeconds>=0.0)?test.expectedSeconds:estimate;
+  };
+
+  std::sort(tests.begin(), tests.end(), [&](const Test_lt& a, const Test_lt& b)
+  {
+    double ea = expected(a);
+    double eb = expected(b);
+    if(ea!=eb)
+      return ea>eb;
+    return a.command<b.command;
+  });
+
+  // Longest processing time first, each test goes to the bucket with the least work so far.
+  std::vector<double> totals(params.shardCount, 0.0);
+  std::vector<Test_lt> shard;
+  for(const auto& test : tests)
+  {
+    size_t bucket = size_t(std::min_element(totals.begin(), totals.end()) - totals.begin());
+    totals.at(bucket) += expected(test);
+    if(bucket == (params.shardIndex-1))
+      shard.push_back(test);
+  }
+
+  std::cout << "Shard " << params.shardIndex << "/" << params.shardCount << ": " << shard.size()
+            << " of " << tests.size() << " tests, expected " << totals.at(params.shardIndex-1) << "s" << std::endl;
+
+  return shard;
+}
+
+//##################################################################################################
+//! Commands that only differ in the characters that are replaced would share a log, these get the
+//! line number of the test added to the name.
+std::string logFileName(const std::string& logDirectory, const std::string& command, size_t index, std::set<std::string>& used)
+{
+  std::string name;
+  for(char c : command)
+    name += (std::isalnum(uint8_t(c)) || c=='_' || c=='-')?c:'_';
+
+  while(!name.empty() && name.front() == '_')
+    name.erase(0, 1);
+
+  if(!used.insert(name).second)
+  {
+    name += "_" + std::to_string(index);
+    used.insert(name);
+  }
+
+  return logDirectory + "/" + name + ".log";
+}
+
+//##################################################################################################
+double toSeconds(const timeval& tv)
+{
+  return double(tv.tv_sec) + double(tv.tv_usec)/1000000.0;
+}
+
+//##################################################################################################
+bool startTest(Test_lt& test, const Params_lt& params)
+{
+  auto args = splitWords(test.command);
+  if(args.empty())
+    return false;
+
+  // The child waits for the counters to be attached before calling exec.
+  int ready[2]={-1, -1};
+  if(params.perfCounters && pipe(ready) != 0)
+    return false;
+
+  test.start = std::chrono::steady_clock::now();
+  test.pid = fork();
+
+  if(test.pid < 0)
+  {
+    std::cerr << "error: Failed to fork test: " << test.command << std::endl;
+    if(ready[0]>=0)
+    {
+      close(ready[0]);
+      close(ready[1]);
+    }
+    return false;
+  }
+
+  if(test.pid == 0)
+  {
+    // Place the test in its own process group so that a timeout kills any children it starts.
+    setpgid(0, 0);
+
+    int fd = open(test.logFile.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if(fd>=0)
+    {
+      dup2(fd, STDOUT_FILENO);
+      dup2(fd, STDERR_FILENO);
+      close(fd);
+    }
+
+    if(params.pinCpus)
+      tp_bench::pinToCpu(int(test.slot % std::max(1u, std::thread::hardware_concurrency())));
+
+    if(params.perfCounters)
+    {
+      char c;
+      close(ready[1]);
+      while(read(ready[0], &c, 1)<0 && errno==EINTR){}
+      close(ready[0]);
+    }
+
+    std::vector<char*> argv;
+    for(auto& arg : args)
+      argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    execvp(argv.front(), argv.data());
+    std::cerr << "error: Failed to execute: " << test.command << std::endl;
+    _exit(127);
+  }
+
+  setpgid(test.pid, test.pid);
+
+  if(params.perfCounters)
+  {
+    test.perfCounters = std::make_shared<tp_bench::PerfCounters>(test.pid, true);
+    close(ready[0]);
+    close(ready[1]);
+  }
+
+  return true;
+}
+
+//##################################################################################################
+void finishTest(Test_lt& test, int status, const rusage& usage)
+{
+  test.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - test.start).count();
+  test.userSeconds = toSeconds(usage.ru_utime);
+  test.systemSeconds = toSeconds(usage.ru_stime);
+
+#ifdef __APPLE__
+  test.peakRssKb = long(usage.ru_maxrss/1024);
+#else
+  test.peakRssKb = long(usage.ru_maxrss);
+#endif
+
+  if(WIFEXITED(status))
+    test.exitCode = WEXITSTATUS(status);
+  else if(WIFSIGNALED(status))
+    test.signal = WTERMSIG(status);
+
+  test.passed = !test.timedOut && WIFEXITED(status) && test.exitCode==0;
+  test.pid = 0;
+
+  if(test.perfCounters)
+  {
+    test.counters = test.perfCounters->read();
+    test.perfCounters.reset();
+  }
+}
+
+//##################################################################################################
+std::string resultString(const Test_lt& test)
+{
+  if(test.passed)
+    return "passed";
+  if(test.timedOut)
+    return "timeout";
+  return "failed";
+}
+
+//##################################################################################################
+std::string failureMessage(const Test_lt& test, const Params_lt& params)
+{
+  if(test.timedOut)
+    return "Timed out after " + std::to_string(int(params.timeout)) + " seconds";
+  if(test.signal)
+    return "Killed by signal " + std::to_string(test.signal);
+  return "Exit code " + std::to_string(test.exitCode);
+}
+
+//##################################################################################################
+void runTests(std::vector<Test_lt>& tests, const Params_lt& params)
+{
+  size_t next=0;
+  std::vector<Test_lt*> running;
+  std::vector<bool> slots(params.jobs, false);
+
+  while(next<tests.size() || !running.empty())
+  {
+    while(next<tests.size() && running.size()<params.jobs)
+    {
+      Test_lt& test = tests.at(next);
+      next++;
+
+      test.slot = size_t(std::find(slots.begin(), slots.end(), false) - slots.begin());
+
+      std::cout << "\033[1;93mRunning test: \033[0m" << test.command << std::endl;
+      if(startTest(test, params))
+      {
+        slots.at(test.slot) = true;
+        running.push_back(&test);
+      }
+      else
+        test.exitCode = 127;
+    }
+
+    int status=0;
+    rusage usage{};
+    pid_t pid = wait4(-1, &status, WNOHANG, &usage);
+
+    if(pid>0)
+    {
+      auto i = std::find_if(running.begin(), running.end(), [&](Test_lt* t){return t->pid == pid;});
+      if(i != running.end())
+      {
+        Test_lt& test = **i;
+        running.erase(i);
+        slots.at(test.slot) = false;
+        finishTest(test, status, usage);
+
+        if(test.passed)
+          std::cout << "    \033[32mPassed: ";
+        else
+          std::cout << "    \033[31m" << (test.timedOut?"Timeout: ":"Failed: ");
+        std::cout << test.command << "\033[39m (" << test.wallSeconds << "s)" << std::endl;
+      }
+      continue;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if(params.timeout>0.0)
+    {
+      for(auto test : running)
+      {
+        double elapsed = std::chrono::duration<double>(now - test->start).count();
+        if(!test->timedOut && elapsed>params.timeout)
+        {
+          test->timedOut = true;
+          kill(-test->pid, SIGTERM);
+        }
+        else if(test->timedOut && !test->killed && elapsed>(params.timeout+5.0))
+        {
+          test->killed = true;
+          kill(-test->pid, SIGKILL);
+        }
+      }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+//##################################################################################################
+void writeJSON(const std::vector<Test_lt>& tests, const Params_lt& params)
+{
+  // One test per line, loadHistory depends on this.
+  std::ofstream out(params.jsonFile);
+  out << "{\n  \"tests\": [\n";
+  for(size_t i=0; i<tests.size(); i++)
+  {
+    const auto& test = tests.at(i);
+    out << "    {\"name\": \"" << escapeJSON(test.command) << "\", "
+        << "\"result\": \"" << resultString(test) << "\", "
+        << "\"exitCode\": " << test.exitCode << ", "
+        << "\"signal\": " << test.signal << ", "
+        << "\"wallSeconds\": " << test.wallSeconds << ", "
+        << "\"userSeconds\": " << test.userSeconds << ", "
+        << "\"systemSeconds\": " << test.systemSeconds << ", "
+        << "\"peakRssKb\": " << test.peakRssKb;
+
+    if(!test.counters.empty())
+    {
+      out << ", \"counters\": {";
+      for(size_t c=0; c<test.counters.size(); c++)
+        out << (c?", ":"") << "\"" << test.counters.at(c).first << "\": " << test.counters.at(c).second;
+      out << "}";
+    }
+
+    out << "}"
+        << ((i+1)<tests.size()?",":"") << "\n";
+  }
+  out << "  ]\n}\n";
+}
+
+//##################################################################################################
+void writeJUnit(const std::vector<Test_lt>& tests, const Params_lt& params)
+{
+  size_t failures=0;
+  double totalSeconds=0.0;
+  for(const auto& test : tests)
+  {
+    failures += test.passed?0:1;
+    totalSeconds += test.wallSeconds;
+  }
+
+  std::ofstream out(params.junitFile);
+  out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+  out << "<testsuites tests=\"" << tests.size() << "\" failures=\"" << failures << "\" time=\"" << totalSeconds << "\">\n";
+  out << "  <testsuite name=\"tests\" tests=\"" << tests.size() << "\" failures=\"" << failures << "\" errors=\"0\" time=\"" << totalSeconds << "\">\n";
+  for(const auto& test : tests)
+  {
+    out << "    <testcase name=\"" << escapeXML(test.command) << "\" classname=\"tests\" time=\"" << test.wallSeconds << "\">\n";
+    if(!test.passed)
+    {
+      std::string log;
+      readTextFile(test.logFile, log);
+      out << "      <failure message=\"" << escapeXML(failureMessage(test, params)) << "\"/>\n";
+      out << "      <system-out>" << escapeXML(log) << "</system-out>\n";
+    }
+    out << "      <properties>\n";
+    out << "        <property name=\"userSeconds\" value=\"" << test.userSeconds << "\"/>\n";
+    out << "        <property name=\"systemSeconds\" value=\"" << test.systemSeconds << "\"/>\n";
+    out << "        <property name=\"peakRssKb\" value=\"" << test.peakRssKb << "\"/>\n";
+    for(const auto& [name, value] : test.counters)
+      out << "        <property name=\"" << name << "\" value=\"" << value << "\"/>\n";
+    out << "      </properties>\n";
+    out << "    </testcase>\n";
+  }
+  out << "  </testsuite>\n</testsuites>\n";
+}
+
+//##################################################################################################
+void printUsage()
+{
+  std::cerr << "Usage: tpTest [options] [tests.txt]\n"
+               "  -j N, --jobs=N       Number of tests to run in parallel, default: number of cores.\n"
+               "  --timeout=SECONDS    Kill tests that run longer than this, default: no timeout.\n"
+               "  --junit=FILE         Write a JUnit XML report.\n"
+               "  --json=FILE          Write a JSON report.\n"
+               "  --history=FILE       JSON report of a previous run used to order tests, longest first.\n"
+               "                       Defaults to the --json file when not sharding, may be given\n"
+               "                       more than once.\n"
+               "  --logs=DIRECTORY     Where to write the output of each test, default: test_logs\n"
+               "  --shard=I/N          Only run the I'th (1 to N) of N buckets of tests, buckets are\n"
+               "                       balanced using the durations from the history files.\n"
+               "  --dry-run            Print the tests that would be run in order without running them.\n"
+               "  --perf-counters      Record hardware performance counters for each test (Linux only).\n"
+               "  --pin-cpus           Pin each running test to its own CPU.\n";
+}
+
+//##################################################################################################
+bool parseArgs(int argc, const char* argv[], Params_lt& params)
+{
+  auto startsWith = [](const std::string& arg, const std::string& prefix)
+  {
+    return arg.compare(0, prefix.size(), prefix) == 0;
+  };
+
+  try
+  {
+    for(int i=1; i<argc; i++)
+    {
+      std::string arg = argv[i];
+
+      if(arg == "-j" && (i+1)<argc)
+        params.jobs = std::stoul(argv[++i]);
+      else if(startsWith(arg, "--jobs="))
+        params.jobs = std::stoul(arg.substr(7));
+      else if(startsWith(arg, "-j"))
+        params.jobs = std::stoul(arg.substr(2));
+      else if(startsWith(arg, "--timeout="))
+        params.timeout = std::stod(arg.substr(10));
+      else if(startsWith(arg, "--junit="))
+        params.junitFile = arg.substr(8);
+      else if(startsWith(arg, "--json="))
+        params.jsonFile = arg.substr(7);
+      else if(startsWith(arg, "--history="))
+        params.historyFiles.push_back(arg.substr(10));
+      else if(startsWith(arg, "--logs="))
+        params.logDirectory = arg.substr(7);
+      else if(startsWith(arg, "--shard="))
+      {
+        auto shard = arg.substr(8);
+        auto slash = shard.find('/');
+        if(slash == std::string::npos)
+          return false;
+        params.shardIndex = std::stoul(shard.substr(0, slash));
+        params.shardCount = std::stoul(shard.substr(slash+1));
+      }
+      else if(arg == "--dry-run")
+        params.dryRun = true;
+      else if(arg == "--perf-counters")
+        params.perfCounters = true;
+      else if(arg == "--pin-cpus")
+        params.pinCpus = true;
+      else if(startsWith(arg, "-"))
+        return false;
+      else
+        params.testsFile = arg;
+    }
+  }
+  catch(...)
+  {
+    return false;
+  }
+
+  if(params.shardCount<1 || params.shardIndex<1 || params.shardIndex>params.shardCount)
+  {
+    std::cerr << "error: Invalid shard, expected --shard=I/N with 1 <= I <= N" << std::endl;
+    return false;
+  }
+
+  if(params.jobs == 0)
+    params.jobs = std::max(1u, std::thread::hardware_concurrency());
+
+  // A sharded run only reports its own tests, so its report can't be used to split the next run.
+  if(params.historyFiles.empty() && !params.jsonFile.empty() && params.shardCount==1)
+    params.historyFiles.push_back(params.jsonFile);
+
+  return true;
+}
+}
+
+//##################################################################################################
+int main(int argc, const char* argv[])
+{
+  Params_lt params;
+  if(!parseArgs(argc, argv, params))
+  {
+    printUsage();
+    return 1;
+  }
+
+  std::string testsText;
+  if(!readTextFile(params.testsFile, testsText))
+  {
+    std::cerr << "error: Failed to read: " << params.testsFile << std::endl;
+    return 1;
+  }
+
+  std::map<std::string, double> history;
+  for(const auto& historyFile : params.historyFiles)
+    loadHistory(historyFile, history);
+
+  mkdir(params.logDirectory.c_str(), 0755);
+
+  std::vector<Test_lt> tests;
+  std::set<std::string> logNames;
+  for(const auto& line : splitLines(testsText))
+  {
+    if(splitWords(line).empty())
+      continue;
+
+    Test_lt& test = tests.emplace_back();
+    test.command = line;
+    test.logFile = logFileName(params.logDirectory, line, tests.size(), logNames);
+
+    if(auto i = history.find(line); i!=history.end())
+      test.expectedSeconds = i->second;
+  }
+
+  tests = selectShard(std::move(tests), params);
+
+  // Start the longest tests first so that the last test to finish is a short one. Tests that we have
+  // no history for are assumed to be long.
+  std::stable_sort(tests.begin(), tests.end(), [](const Test_lt& a, const Test_lt& b)
+  {
+    if((a.expectedSeconds<0.0) != (b.expectedSeconds<0.0))
+      return a.expectedSeconds<0.0;
+    return a.expectedSeconds>b.expectedSeconds;
+  });
+
+  if(params.dryRun)
+  {
+    for(const auto& test : tests)
+      std::cout << test.command << std::endl;
+    return 0;
+  }
+
+  if(params.perfCounters || params.pinCpus)
+  {
+    for(const auto& [cpu, governor] : tp_bench::checkGovernors())
+      std::cerr << "warning: CPU " << cpu << " is using the " << governor << " frequency governor, timings will be noisy." << std::endl;
+  }
+
+  if(params.perfCounters && !tp_bench::PerfCounters().isValid())
+    std::cerr << "warning: Some performance counters are not available, check /proc/sys/kernel/perf_event_paranoid" << std::endl;
+
+  auto start = std::chrono::steady_clock::now();
+  runTests(tests, params);
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if(!params.jsonFile.empty())
+    writeJSON(tests, params);
+
+  if(!params.junitFile.empty())
+    writeJUnit(tests, params);
+
+  size_t failures=0;
+  std::string results = "\nTest Results:\n";
+  for(const auto& test : tests)
+  {
+    if(test.passed)
+      results += "    \033[32mPassed: " + test.command + "\033[39m\n";
+    else
+    {
+      failures++;
+      results += "    \033[31mFailed: " + test.command + " (" + failureMessage(test, params) + ")\033[39m\n";
+
+      std::string log;
+      readTextFile(test.logFile, log);
+      std::cout << "\n\033[1;31mOutput of failed test: \033[0m" << test.command << "\n" << log;
+    }
+  }
+
+  std::cout << results;
+  std::cout << "\n" << (tests.size()-failures) << " of " << tests.size() << " tests passed in " << wallSeconds << "s" << std::endl;
+
+  return failures?1:0;
+}
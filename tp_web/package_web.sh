@@ -0,0 +1,153 @@
+#!/bin/bash
+
+# Packages the output of an emcc link for serving, each file is given a content hashed name so that
+# it can be cached forever and is precompressed so that the server doesn't have to.
+#   package_web.sh <output directory> <name> <files...>
+#
+# This writes:
+#   <stem>.<hash>.<ext>     - For each input file (js, wasm, data, worker.js).
+#   <stem>.<hash>.<ext>.gz  - gzip -9, served with Content-Encoding: gzip.
+#   <stem>.<hash>.<ext>.br  - brotli, only if the brotli command is available.
+#   <name>.loader.js        - Small loader to include in the page, this must not be cached.
+#
+# Side modules (<lib>.side.wasm) and the deferred part of a split module (<name>.deferred.wasm) are
+# packaged the same way and found by emscripten through Module.locateFile.
+#
+# The loader compiles the wasm while it downloads using WebAssembly.instantiateStreaming, this needs
+# the server to send .wasm files as application/wasm, otherwise it falls back to a normal compile.
+
+set -e
+
+OUTPUT_DIR=$1
+NAME=$2
+shift
+shift
+
+mkdir -p "${OUTPUT_DIR}"
+rm -f "${OUTPUT_DIR}/${NAME}".*
+for f in "$@"; do
+  base=$(basename "${f}")
+  rm -f "${OUTPUT_DIR}/${base%%.*}".*
+done
+
+if which sha256sum > /dev/null 2>&1; then
+  HASH_CMD="sha256sum"
+else
+  HASH_CMD="shasum -a 256"
+fi
+
+HAS_BROTLI=0
+if which brotli > /dev/null 2>&1; then
+  HAS_BROTLI=1
+else
+  echo "warning: brotli not found, only gzip files will be written." >&2
+fi
+
+# Emscripten finds the deferred wasm of a split module next to the main wasm, so both share a hash
+# that covers the contents of both files.
+DEFERRED=""
+for f in "$@"; do
+  if [ "$(basename "${f}")" == "${NAME}.deferred.wasm" ] && [ -f "${f}" ]; then
+    DEFERRED="${f}"
+  fi
+done
+
+FILES=""
+JS=""
+WASM=""
+for f in "$@"; do
+  if [ ! -f "${f}" ]; then
+    continue
+  fi
+
+  base=$(basename "${f}")
+  stem=${base%%.*}
+  ext=${base#*.}
+  if [ -n "${DEFERRED}" ] && [ "${stem}" == "${NAME}" ] && ( [ "${ext}" == "wasm" ] || [ "${ext}" == "deferred.wasm" ] ); then
+    hash=$(cat "${f%${base}}${NAME}.wasm" "${DEFERRED}" | ${HASH_CMD} | cut -c1-16)
+  else
+    hash=$(${HASH_CMD} "${f}" | cut -c1-16)
+  fi
+  hashed="${stem}.${hash}.${ext}"
+
+  cp "${f}" "${OUTPUT_DIR}/${hashed}"
+  gzip -9 -n -k -f "${OUTPUT_DIR}/${hashed}"
+  if [ ${HAS_BROTLI} -eq 1 ]; then
+    brotli -q 11 -k -f "${OUTPUT_DIR}/${hashed}"
+  fi
+
+  FILES="${FILES}\"${base}\":\"${hashed}\","
+  case "${base}" in
+    "${NAME}.js")   JS="${hashed}" ;;
+    "${NAME}.wasm") WASM="${hashed}" ;;
+  esac
+done
+
+if [ -z "${JS}" ]; then
+  echo "error: No ${NAME}.js given." >&2
+  exit 1
+fi
+
+cat > "${OUTPUT_DIR}/${NAME}.loader.js" << EOF
+// Generated by tp_build/tp_web/package_web.sh
+var Module = typeof Module !== 'undefined' ? Module : {};
+(function()
+{
+  var files = {${FILES%,}};
+  var base = document.currentScript ? document.currentScript.src.replace(/[^\/]*$/, '') : '';
+
+  Module.locateFile = function(path)
+  {
+    return base + (files[path] || path);
+  };
+
+  if("${WASM}")
+  {
+    Module.instantiateWasm = function(imports, successCallback)
+    {
+      var url = base + "${WASM}";
+      var streaming = WebAssembly.instantiateStreaming ?
+            WebAssembly.instantiateStreaming(fetch(url, {credentials: 'same-origin'}), imports) :
+            Promise.reject();
+
+      streaming.catch(function(error)
+      {
+        // Servers that don't send application/wasm can't be compiled while streaming, a module that
+        // fails to compile or link would fail again so it is not fetched twice.
+        if(error instanceof WebAssembly.CompileError || error instanceof WebAssembly.LinkError)
+          throw error;
+
+        return fetch(url, {credentials: 'same-origin'}).then(function(response)
+        {
+          if(!response.ok)
+            throw new Error('Failed to fetch ' + url + ': ' + response.status);
+          return response.arrayBuffer();
+        }).then(function(bytes)
+        {
+          return WebAssembly.instantiate(bytes, imports);
+        });
+      }).then(function(result)
+      {
+        successCallback(result.instance, result.module);
+      }).catch(function(error)
+      {
+        var message = 'Failed to load ' + url + ': ' + error;
+        (Module.printErr || console.error)(message);
+        if(Module.abort)
+          Module.abort(message);
+        else if(Module.onAbort)
+          Module.onAbort(message);
+      });
+
+      return {};
+    };
+  }
+
+  var script = document.createElement('script');
+  script.src = base + "${JS}";
+  script.async = true;
+  document.head.appendChild(script);
+})();
+EOF
+
+echo "Packaged ${NAME} into: ${OUTPUT_DIR}"